@@ -11,6 +11,8 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
+import 'dart:io';
+
 import 'package:flutter/material.dart';
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
@@ -42,4 +44,122 @@ void main() {
         ]),
         completes);
   });
+
+  // Stats are cumulative, so tests compare them with the stats from before.
+  Future<MenubarStats> statsChange(MenubarStats before) async {
+    final after = await getApplicationMenuStats();
+    return MenubarStats(
+        reuseHits: after.reuseHits - before.reuseHits,
+        reuseMisses: after.reuseMisses - before.reuseMisses);
+  }
+
+  List<NativeSubmenu> buildMenu(
+      {List<String> editLabels = const ['Cut', 'Copy', 'Paste'],
+      bool pasteEnabled = true,
+      bool includeView = false}) {
+    return [
+      NativeSubmenu(label: 'File', children: [
+        NativeMenuItem(label: 'Open', onSelected: () {}),
+        const NativeMenuDivider(),
+        NativeMenuItem(label: 'Quit', onSelected: () {}),
+      ]),
+      NativeSubmenu(label: 'Edit', children: [
+        for (final label in editLabels)
+          NativeMenuItem(
+              label: label,
+              onSelected: label != 'Paste' || pasteEnabled ? () {} : null),
+        const NativeMenuDivider(),
+        NativeSubmenu(label: 'Presets', children: [
+          NativeMenuItem(label: 'Small', onSelected: () {}),
+          NativeMenuItem(label: 'Large', onSelected: () {}),
+        ]),
+      ]),
+      if (includeView)
+        NativeSubmenu(label: 'View', children: [
+          NativeMenuItem(label: 'Zoom', onSelected: () {}),
+        ]),
+    ];
+  }
+
+  testWidgets('update applies moved, relabeled and disabled items',
+      (tester) async {
+    await setApplicationMenu(buildMenu());
+    final before = await getApplicationMenuStats();
+
+    await updateApplicationMenu(buildMenu(
+        editLabels: ['Copy', 'Cut Selection', 'Paste'], pasteEnabled: false));
+
+    // Only the top level and Edit change; File and Presets are left alone.
+    final change = await statsChange(before);
+    expect(change.reuseHits, 2);
+    expect(change.reuseMisses, 2);
+  }, skip: !Platform.isLinux);
+
+  testWidgets('inserting an item keeps the ids of the others', (tester) async {
+    await setApplicationMenu(buildMenu());
+    final before = await getApplicationMenuStats();
+
+    await updateApplicationMenu(
+        buildMenu(editLabels: ['Undo', 'Cut', 'Copy', 'Paste']));
+
+    // Presets, after the inserted item, keeps its item ids, so it is reused.
+    final change = await statsChange(before);
+    expect(change.reuseHits, 2);
+    expect(change.reuseMisses, 2);
+  }, skip: !Platform.isLinux);
+
+  testWidgets('updating a hidden item applies when it is shown again',
+      (tester) async {
+    final menu = buildMenu();
+    await setApplicationMenu(menu);
+    final paste = menu[1].children[2] as NativeMenuItem;
+
+    await updateApplicationMenuItems(
+        [NativeMenuItemUpdate(paste, visible: false)]);
+    await updateApplicationMenuItems([
+      NativeMenuItemUpdate(paste, label: 'Paste Here', enabled: false),
+      NativeMenuItemUpdate(paste, visible: true),
+    ]);
+    final before = await getApplicationMenuStats();
+
+    // The changed lists no longer match the spec, so they are updated to
+    // restore it, while File and Presets are still reused.
+    await updateApplicationMenu(menu);
+    final change = await statsChange(before);
+    expect(change.reuseHits, 2);
+    expect(change.reuseMisses, 2);
+  }, skip: !Platform.isLinux);
+
+  testWidgets('updating an item in a large submenu does not build it',
+      (tester) async {
+    final items = [
+      for (var i = 0; i < 200; i++)
+        NativeMenuItem(label: 'Item $i', onSelected: () {}),
+    ];
+    await setApplicationMenu([
+      NativeSubmenu(label: 'Large', children: items),
+    ]);
+    final before = await getApplicationMenuStats();
+
+    await updateApplicationMenuItems([
+      NativeMenuItemUpdate(items[150], label: 'Renamed', enabled: false),
+    ]);
+
+    // The submenu isn't shown, so nothing is built until it is.
+    final change = await statsChange(before);
+    expect(change.reuseHits, 0);
+    expect(change.reuseMisses, 0);
+  }, skip: !Platform.isLinux);
+
+  testWidgets('unchanged submenus are reused across set', (tester) async {
+    await setApplicationMenu(buildMenu());
+    final before = await getApplicationMenuStats();
+
+    await setApplicationMenu(buildMenu(
+        editLabels: ['Cut', 'Copy', 'Paste Special'], includeView: true));
+
+    // File and Presets are taken from the previous menu.
+    final change = await statsChange(before);
+    expect(change.reuseHits, 2);
+  }, skip: !Platform.isLinux);
 }
@@ -16,7 +16,9 @@ import 'dart:async';
 import 'package:flutter/services.dart';
 import 'package:flutter/widgets.dart';
 
+import 'menubar_stats.dart';
 import 'native_menu_item.dart';
+import 'native_menu_item_update.dart';
 
 /// Whether or not the menu item is a divider, as a boolean. If true, no other
 /// The name of the plugin's platform channel.
@@ -28,6 +30,37 @@ const String _kMenuChannelName = 'flutter/menubar';
 /// of menus that should be set as top-level menu items.
 const String _kMenuSetMethod = 'Menubar.SetMenu';
 
+/// The method name to instruct the native plugin to update the menu to match
+/// a new one.
+//
+/// The argument is the same as for _kMenuSetMethod. Instead of rebuilding the
+/// menu, the plugin matches items to those already shown, by _kIdKey for
+/// items that have one and by label for submenus, and only changes the ones
+/// that differ.
+const String _kMenuUpdateMethod = 'Menubar.UpdateMenu';
+
+/// The method name to instruct the native plugin to change individual items
+/// of the current menu in place.
+//
+/// The argument is an array of maps, each with the _kIdKey of an item in the
+/// current menu and any of _kLabelKey, _kEnabledKey and _kVisibleKey to
+/// change. Changes last until the next _kMenuSetMethod or _kMenuUpdateMethod
+/// call.
+const String _kMenuUpdateItemsMethod = 'Menubar.UpdateItems';
+
+/// The method name to get counters from the native plugin.
+//
+/// The result is a map with _kReuseHitsKey and _kReuseMissesKey.
+const String _kGetStatsMethod = 'Menubar.GetStats';
+
+/// The number of menus, including submenus, that were unchanged when a menu
+/// was set or updated, and so were reused, as an integer.
+const String _kReuseHitsKey = 'reuseHits';
+
+/// The number of menus, including submenus, that had to be built or updated
+/// when a menu was set or updated, as an integer.
+const String _kReuseMissesKey = 'reuseMisses';
+
 /// The method name for the Dart-side callback called when a menu item is
 /// selected.
 //
@@ -40,6 +73,11 @@ const String _kMenuItemSelectedCallbackMethod = 'Menubar.SelectedCallback';
 /// The ID of the menu item, as an integer. If present, this indicates that the
 /// menu item should trigger a kMenuItemSelectedCallbackMethod call when
 /// selected.
+///
+/// Every non-submenu item has an ID, including disabled ones. An item keeps
+/// its ID across menus as long as it has the same [NativeMenuItem.key], or,
+/// without a key, is the same object or has the same label and submenu path,
+/// so that inserting or removing an item doesn't change the IDs of the others.
 const String _kIdKey = 'id';
 
 /// The label that should be displayed for the menu, as a string.
@@ -70,6 +108,10 @@ const String _kShortcutKeyModifiers = 'keyModifiers';
 /// the defualt is to enabled the item.
 const String _kEnabledKey = 'enabled';
 
+/// Whether or not the menu item should be shown, as a boolean. Only used in
+/// _kMenuUpdateItemsMethod calls.
+const String _kVisibleKey = 'visible';
+
 /// Menu items that should be shown as a submenu of this item, as an array.
 const String _kChildrenKey = 'children';
 
@@ -115,7 +157,26 @@ class MenuChannel {
   /// those menu items.
   final Map<int, VoidCallback> _selectionCallbacks = {};
 
-  /// The ID to use the next time a menu item needs an ID assigned.
+  /// Map from the menu items in the current menu to their IDs.
+  Map<NativeMenuItem, int> _menuItemIds = Map.identity();
+
+  /// Map from the keys of the menu items in the current menu, as returned by
+  /// [_menuItemKey], to their IDs.
+  Map<String, int> _menuItemIdsByKey = {};
+
+  /// _menuItemIds and _menuItemIdsByKey for the previous menu, while
+  /// converting a new one.
+  Map<NativeMenuItem, int> _previousMenuItemIds = Map.identity();
+  Map<String, int> _previousMenuItemIdsByKey = {};
+
+  /// The IDs assigned so far while converting a menu, to give items that
+  /// would otherwise share an ID different ones.
+  final Set<int> _usedMenuItemIds = {};
+
+  /// The ID to use the next time a menu item needs a new ID.
+  ///
+  /// This is never reset, so that a new item never takes the ID of an item
+  /// from an earlier menu.
   int _nextMenuItemId = 1;
 
   /// Whether or not a call to [_kMenuSetMethod] is outstanding.
@@ -134,10 +195,65 @@ class MenuChannel {
   /// For instance, special menus that are handled entirely on the native
   /// side might be added to the provided menus.
   Future<Null> setMenu(List<NativeSubmenu> menus) async {
+    await _sendMenu(_kMenuSetMethod, menus);
+  }
+
+  /// Updates the native application menu to match [menus].
+  ///
+  /// The result is the same as [setMenu], but only the items that differ from
+  /// the current menu are changed natively, which is much cheaper when
+  /// updates are frequent and small.
+  Future<Null> updateMenu(List<NativeSubmenu> menus) async {
+    await _sendMenu(_kMenuUpdateMethod, menus);
+  }
+
+  /// Changes individual items of the current menu in place.
+  ///
+  /// Throws an [ArgumentError] if an item is not in the current menu, or
+  /// would be enabled without a selection callback.
+  Future<Null> updateMenuItems(List<NativeMenuItemUpdate> updates) async {
+    final representation = updates.map((update) {
+      final id = _menuItemIds[update.item];
+      if (id == null) {
+        throw ArgumentError('Menu item is not in the current menu: '
+            '${update.item.label}');
+      }
+      final enabled = update.enabled;
+      if (enabled == true && update.item.onSelected == null) {
+        throw ArgumentError('Menu item without onSelected can not be enabled: '
+            '${update.item.label}');
+      }
+      return <String, dynamic>{
+        _kIdKey: id,
+        if (update.label != null) _kLabelKey: update.label,
+        if (enabled != null) _kEnabledKey: enabled,
+        if (update.visible != null) _kVisibleKey: update.visible,
+      };
+    }).toList();
+    try {
+      await _platformChannel.invokeMethod(
+          _kMenuUpdateItemsMethod, representation);
+    } on PlatformException catch (e) {
+      print('Platform exception updating menu items: ${e.message}');
+    }
+  }
+
+  /// Gets counters for how the native plugin has applied menus.
+  Future<MenubarStats> getStats() async {
+    final response =
+        await _platformChannel.invokeMethod(_kGetStatsMethod) as Map;
+    return MenubarStats(
+      reuseHits: response[_kReuseHitsKey] as int,
+      reuseMisses: response[_kReuseMissesKey] as int,
+    );
+  }
+
+  /// Sends [menus] to the native plugin with [method].
+  Future<Null> _sendMenu(String method, List<NativeSubmenu> menus) async {
     try {
       _updateInProgress = true;
       await _platformChannel.invokeMethod(
-          _kMenuSetMethod, _channelRepresentationForMenus(menus));
+          method, _channelRepresentationForMenus(menus));
       _updateInProgress = false;
     } on PlatformException catch (e) {
       print('Platform exception setting menu: ${e.message}');
@@ -149,18 +265,64 @@ class MenuChannel {
   ///
   /// As a side-effect, repopulates _selectionCallbacks with a mapping from
   /// the IDs assigned to any menu item with a selection handler to the
-  /// callback that should be triggered.
+  /// callback that should be triggered, reusing the IDs of items from the
+  /// previous menu.
   List<dynamic> _channelRepresentationForMenus(List<NativeSubmenu> menus) {
+    _previousMenuItemIds = _menuItemIds;
+    _previousMenuItemIdsByKey = _menuItemIdsByKey;
     _selectionCallbacks.clear();
-    _nextMenuItemId = 1;
+    _menuItemIds = Map.identity();
+    _menuItemIdsByKey = {};
+    _usedMenuItemIds.clear();
+
+    final labelCounts = <String, int>{};
+    final representation = menus
+        .map((menu) => _channelRepresentationForMenuItem(
+            menu, _menuItemPath('', menu, labelCounts)))
+        .toList();
+    _previousMenuItemIds = Map.identity();
+    _previousMenuItemIdsByKey = {};
+    return representation;
+  }
+
+  /// Returns the path of [item] within the menu, given the [parentPath] of the
+  /// menu containing it and the [labelCounts] of the items before it in that
+  /// menu.
+  String _menuItemPath(String parentPath, AbstractNativeMenuItem item,
+      Map<String, int> labelCounts) {
+    final count = labelCounts[item.label] ?? 0;
+    labelCounts[item.label] = count + 1;
+    // Labels may contain any character, so the parts are length-prefixed.
+    return '$parentPath${item.label.length}:${item.label}#$count/';
+  }
+
+  /// Returns the key under which the ID of [item], at [path], is kept across
+  /// menus.
+  String _menuItemKey(NativeMenuItem item, String path) {
+    final key = item.key;
+    return key != null ? 'key:$key' : 'path:$path';
+  }
 
-    return menus.map(_channelRepresentationForMenuItem).toList();
+  /// Returns the ID for [item] at [path], which is the ID it had in the
+  /// previous menu if any, and records it in _menuItemIds.
+  int _menuItemId(NativeMenuItem item, String path) {
+    final key = _menuItemKey(item, path);
+    var id = item.key != null
+        ? _previousMenuItemIdsByKey[key]
+        : _previousMenuItemIds[item] ?? _previousMenuItemIdsByKey[key];
+    if (id == null || !_usedMenuItemIds.add(id)) {
+      id = _nextMenuItemId++;
+      _usedMenuItemIds.add(id);
+    }
+    _menuItemIds[item] = id;
+    _menuItemIdsByKey[key] = id;
+    return id;
   }
 
-  /// Returns a representation of [item] suitable for passing over the
-  /// platform channel to the native plugin.
+  /// Returns a representation of [item], at [path], suitable for passing over
+  /// the platform channel to the native plugin.
   Map<String, dynamic> _channelRepresentationForMenuItem(
-      AbstractNativeMenuItem item) {
+      AbstractNativeMenuItem item, String path) {
     final representation = <String, dynamic>{};
     if (item is NativeMenuDivider) {
       representation[_kDividerKey] = true;
@@ -168,13 +330,14 @@ class MenuChannel {
       representation[_kLabelKey] = item.label;
       if (item is NativeSubmenu) {
         representation[_kChildrenKey] =
-            _channelRepresentationForMenu(item.children);
+            _channelRepresentationForMenu(item.children, path);
       } else if (item is NativeMenuItem) {
         final handler = item.onSelected;
+        final id = _menuItemId(item, path);
+        _storeMenuCallback(id, handler);
+        representation[_kIdKey] = id;
         if (handler == null) {
           representation[_kEnabledKey] = false;
-        } else {
-          representation[_kIdKey] = _storeMenuCallback(handler);
         }
         final shortcut = item.shortcut;
         if (shortcut != null) {
@@ -188,11 +351,12 @@ class MenuChannel {
     return representation;
   }
 
-  /// Returns the representation of [menu] suitable for passing over the
-  /// platform channel to the native plugin.
+  /// Returns the representation of [menu], at [path], suitable for passing
+  /// over the platform channel to the native plugin.
   List<dynamic> _channelRepresentationForMenu(
-      List<AbstractNativeMenuItem> menu) {
+      List<AbstractNativeMenuItem> menu, String path) {
     final menuItemRepresentations = [];
+    final labelCounts = <String, int>{};
     // Dividers are only allowed after non-divider items (see ApplicationMenu).
     var skipNextDivider = true;
     for (final menuItem in menu) {
@@ -201,7 +365,8 @@ class MenuChannel {
         continue;
       }
       skipNextDivider = isDivider;
-      menuItemRepresentations.add(_channelRepresentationForMenuItem(menuItem));
+      menuItemRepresentations.add(_channelRepresentationForMenuItem(
+          menuItem, _menuItemPath(path, menuItem, labelCounts)));
     }
     // If the last item is a divider, remove it (see ApplicationMenu).
     if (skipNextDivider && menuItemRepresentations.isNotEmpty) {
@@ -254,15 +419,14 @@ class MenuChannel {
     channelRepresentation[_kShortcutKeyModifiers] = modifiers;
   }
 
-  /// Stores [callback] for use plugin callback handling, returning the ID
-  /// under which it was stored.
+  /// Stores [callback] for use plugin callback handling under [id].
   ///
-  /// The returned ID should be attached to the menu so that the native plugin
-  /// can identify the menu item selected in the callback.
-  int _storeMenuCallback(VoidCallback callback) {
-    final id = _nextMenuItemId++;
-    _selectionCallbacks[id] = callback;
-    return id;
+  /// The ID should be attached to the menu so that the native plugin can
+  /// identify the menu item selected in the callback.
+  void _storeMenuCallback(int id, VoidCallback? callback) {
+    if (callback != null) {
+      _selectionCallbacks[id] = callback;
+    }
   }
 
   /// Mediates between the platform channel callback and the client callback.
@@ -0,0 +1,26 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// Counters for how the native plugin has applied application menus.
+class MenubarStats {
+  /// Creates a new stats object with the given values.
+  const MenubarStats({required this.reuseHits, required this.reuseMisses});
+
+  /// The number of menus and submenus that were unchanged from ones already
+  /// built, and so were reused rather than rebuilt.
+  final int reuseHits;
+
+  /// The number of menus and submenus that had to be built or updated.
+  final int reuseMisses;
+}
@@ -29,8 +29,19 @@ class NativeMenuItem extends AbstractNativeMenuItem {
     required String label,
     this.shortcut,
     this.onSelected,
+    this.key,
   }) : super(label);
 
+  /// A key that identifies this item across menus, if any.
+  ///
+  /// When a menu is set or updated, an item with the same key as an item in
+  /// the previous menu is treated as the same item, even if it is a different
+  /// object or has been relabeled, so within its submenu it is changed in
+  /// place rather than replaced. Items without a key are matched by object
+  /// identity, then by their label and submenu labels. Keys should be unique
+  /// within a menu.
+  final String? key;
+
   /// The callback to call whenever the menu item is selected.
   ///
   /// If null, the menu item is disabled.
@@ -42,6 +53,13 @@ class NativeMenuItem extends AbstractNativeMenuItem {
   /// specified with one of those. The actual left/right distinction will be
   /// ignored. This part of the API is likely to change in the future.
   ///
+  /// On Linux, shortcuts with a Control, Alt or Meta modifier are handled
+  /// natively: the key press selects the item through [onSelected], and is not
+  /// delivered to Flutter. This takes precedence over widgets with focus, so
+  /// for example Control+C and Control+V on menu items replace text fields'
+  /// clipboard handling. Other shortcuts, such as Delete, are only shown in
+  /// the menu, and are delivered to Flutter as usual.
+  ///
   /// Example: a Save menu item would likely use:
   ///   LogicalKeySet(LogicalKeyboardKey.meta, LogicalKeyboardKey.keyS)
   final LogicalKeySet? shortcut;
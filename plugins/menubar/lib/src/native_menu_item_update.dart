@@ -0,0 +1,41 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+import 'native_menu_item.dart';
+
+/// A change to a single item of the current application menu.
+///
+/// Only the properties that are not null are changed.
+class NativeMenuItemUpdate {
+  /// Creates an update for [item], which must be in the current menu.
+  const NativeMenuItemUpdate(
+    this.item, {
+    this.label,
+    this.enabled,
+    this.visible,
+  });
+
+  /// The item to change, as passed to setApplicationMenu or
+  /// updateApplicationMenu.
+  final NativeMenuItem item;
+
+  /// The new label for the item.
+  final String? label;
+
+  /// Whether the item can be selected. Only items with an
+  /// [NativeMenuItem.onSelected] callback can be enabled.
+  final bool? enabled;
+
+  /// Whether the item is shown.
+  final bool? visible;
+}
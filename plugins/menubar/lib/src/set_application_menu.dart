@@ -14,12 +14,58 @@
 import 'dart:async';
 
 import 'menu_channel.dart';
+import 'menubar_stats.dart';
 import 'native_menu_item.dart';
+import 'native_menu_item_update.dart';
 
 /// Sets the application menu for the app based on the [menuSpec].
 ///
 /// Adjacent [NativeMenuDivider]s will be coalesced, leading and/or trailing
 /// [NativeMenuDivider]s will be removed.
+///
+/// On Linux, submenus with many items are only built natively when first
+/// shown. Their items are still compared with the current menu on each call
+/// to this or [updateApplicationMenu], so this only saves building them.
 Future<Null> setApplicationMenu(List<NativeSubmenu> menuSpec) async {
   await MenuChannel.instance.setMenu(menuSpec);
 }
+
+/// Updates the application menu to match [menuSpec].
+///
+/// The resulting menu is the same as with [setApplicationMenu], but only the
+/// items that differ from the current menu are changed, so this is the better
+/// choice for frequent updates such as enabling or disabling items as the
+/// selection changes. Menu items are matched to the current menu by their
+/// [NativeMenuItem.key], or without one by object identity and then by label,
+/// so a disabled or moved item is changed in place rather than replaced, as
+/// is a relabeled item with a key. Submenus are matched by their labels, and
+/// sections between dividers by the items in them.
+///
+/// Currently only implemented for Linux; other platforms should use
+/// [setApplicationMenu].
+Future<Null> updateApplicationMenu(List<NativeSubmenu> menuSpec) async {
+  await MenuChannel.instance.updateMenu(menuSpec);
+}
+
+/// Changes individual items of the current application menu, without
+/// resending the rest of the menu.
+///
+/// Each item must be in the menu last passed to [setApplicationMenu] or
+/// [updateApplicationMenu], and the changes last until the next call to
+/// either of them. This is the cheapest way to make frequent changes to a few
+/// items, such as enabling and disabling them as the selection changes.
+///
+/// Currently only implemented for Linux.
+Future<Null> updateApplicationMenuItems(
+    List<NativeMenuItemUpdate> updates) async {
+  await MenuChannel.instance.updateMenuItems(updates);
+}
+
+/// Returns counters for how the application menu has been applied natively,
+/// such as how many unchanged submenus were reused rather than rebuilt when
+/// calling [setApplicationMenu] or [updateApplicationMenu].
+///
+/// Currently only implemented for Linux.
+Future<MenubarStats> getApplicationMenuStats() async {
+  return await MenuChannel.instance.getStats();
+}
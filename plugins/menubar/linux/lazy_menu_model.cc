@@ -0,0 +1,174 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "lazy_menu_model.h"
+
+struct _FlMenubarLazyMenuModel {
+  GMenuModel parent_instance;
+
+  // Application the action was added to.
+  GtkApplication* application;
+
+  // Action GTK changes the state of when the submenu is shown.
+  GSimpleAction* action;
+  gchar* action_name;
+
+  FlMenubarLazyMenuModelBuildFunc build_func;
+  gpointer build_user_data;
+  GDestroyNotify build_destroy_notify;
+
+  // Menu with the items, or nullptr if they haven't been built.
+  GMenuModel* menu;
+};
+
+G_DEFINE_TYPE(FlMenubarLazyMenuModel, fl_menubar_lazy_menu_model,
+              g_menu_model_get_type())
+
+// Used to give each model's action a different name.
+static guint next_action_id = 1;
+
+// Called when the submenu is shown or hidden.
+static void change_state_cb(GSimpleAction* action, GVariant* value,
+                            gpointer user_data) {
+  FlMenubarLazyMenuModel* self = FL_MENUBAR_LAZY_MENU_MODEL(user_data);
+  g_simple_action_set_state(action, value);
+  if (g_variant_get_boolean(value)) fl_menubar_lazy_menu_model_build(self);
+}
+
+// Called when the items of the mirrored menu change.
+static void items_changed_cb(GMenuModel* menu, gint position, gint removed,
+                             gint added, gpointer user_data) {
+  g_menu_model_items_changed(G_MENU_MODEL(user_data), position, removed,
+                             added);
+}
+
+static gboolean fl_menubar_lazy_menu_model_is_mutable(GMenuModel* model) {
+  return TRUE;
+}
+
+static gint fl_menubar_lazy_menu_model_get_n_items(GMenuModel* model) {
+  FlMenubarLazyMenuModel* self = FL_MENUBAR_LAZY_MENU_MODEL(model);
+  return self->menu != nullptr ? g_menu_model_get_n_items(self->menu) : 0;
+}
+
+static void fl_menubar_lazy_menu_model_get_item_attributes(
+    GMenuModel* model, gint index, GHashTable** attributes) {
+  FlMenubarLazyMenuModel* self = FL_MENUBAR_LAZY_MENU_MODEL(model);
+  G_MENU_MODEL_GET_CLASS(self->menu)
+      ->get_item_attributes(self->menu, index, attributes);
+}
+
+static void fl_menubar_lazy_menu_model_get_item_links(GMenuModel* model,
+                                                      gint index,
+                                                      GHashTable** links) {
+  FlMenubarLazyMenuModel* self = FL_MENUBAR_LAZY_MENU_MODEL(model);
+  G_MENU_MODEL_GET_CLASS(self->menu)
+      ->get_item_links(self->menu, index, links);
+}
+
+static void fl_menubar_lazy_menu_model_dispose(GObject* object) {
+  FlMenubarLazyMenuModel* self = FL_MENUBAR_LAZY_MENU_MODEL(object);
+
+  fl_menubar_lazy_menu_model_set_build_func(self, nullptr, nullptr, nullptr);
+  if (self->application != nullptr) {
+    // Skip the "app." prefix.
+    g_action_map_remove_action(G_ACTION_MAP(self->application),
+                               self->action_name + 4);
+  }
+  g_clear_object(&self->application);
+  g_clear_object(&self->action);
+  g_clear_object(&self->menu);
+
+  G_OBJECT_CLASS(fl_menubar_lazy_menu_model_parent_class)->dispose(object);
+}
+
+static void fl_menubar_lazy_menu_model_finalize(GObject* object) {
+  FlMenubarLazyMenuModel* self = FL_MENUBAR_LAZY_MENU_MODEL(object);
+
+  g_free(self->action_name);
+
+  G_OBJECT_CLASS(fl_menubar_lazy_menu_model_parent_class)->finalize(object);
+}
+
+static void fl_menubar_lazy_menu_model_class_init(
+    FlMenubarLazyMenuModelClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = fl_menubar_lazy_menu_model_dispose;
+  G_OBJECT_CLASS(klass)->finalize = fl_menubar_lazy_menu_model_finalize;
+
+  GMenuModelClass* model_class = G_MENU_MODEL_CLASS(klass);
+  model_class->is_mutable = fl_menubar_lazy_menu_model_is_mutable;
+  model_class->get_n_items = fl_menubar_lazy_menu_model_get_n_items;
+  model_class->get_item_attributes =
+      fl_menubar_lazy_menu_model_get_item_attributes;
+  model_class->get_item_links = fl_menubar_lazy_menu_model_get_item_links;
+}
+
+static void fl_menubar_lazy_menu_model_init(FlMenubarLazyMenuModel* self) {}
+
+FlMenubarLazyMenuModel* fl_menubar_lazy_menu_model_new(
+    GtkApplication* application) {
+  FlMenubarLazyMenuModel* self = FL_MENUBAR_LAZY_MENU_MODEL(
+      g_object_new(fl_menubar_lazy_menu_model_get_type(), nullptr));
+
+  self->application = GTK_APPLICATION(g_object_ref(application));
+  g_autofree gchar* name =
+      g_strdup_printf("flutter-lazy-menu-%u", next_action_id++);
+  self->action_name = g_strdup_printf("app.%s", name);
+  self->action = g_simple_action_new_stateful(name, nullptr,
+                                              g_variant_new_boolean(FALSE));
+  g_signal_connect_object(self->action, "change-state",
+                          G_CALLBACK(change_state_cb), self,
+                          static_cast<GConnectFlags>(0));
+  g_action_map_add_action(G_ACTION_MAP(application), G_ACTION(self->action));
+
+  return self;
+}
+
+void fl_menubar_lazy_menu_model_set_build_func(
+    FlMenubarLazyMenuModel* self, FlMenubarLazyMenuModelBuildFunc build_func,
+    gpointer user_data, GDestroyNotify destroy_notify) {
+  g_return_if_fail(FL_IS_MENUBAR_LAZY_MENU_MODEL(self));
+
+  if (self->build_destroy_notify != nullptr) {
+    self->build_destroy_notify(self->build_user_data);
+  }
+  self->build_func = build_func;
+  self->build_user_data = user_data;
+  self->build_destroy_notify = destroy_notify;
+}
+
+const gchar* fl_menubar_lazy_menu_model_get_action_name(
+    FlMenubarLazyMenuModel* self) {
+  g_return_val_if_fail(FL_IS_MENUBAR_LAZY_MENU_MODEL(self), nullptr);
+  return self->action_name;
+}
+
+void fl_menubar_lazy_menu_model_build(FlMenubarLazyMenuModel* self) {
+  g_return_if_fail(FL_IS_MENUBAR_LAZY_MENU_MODEL(self));
+
+  if (self->menu == nullptr && self->build_func != nullptr) {
+    self->build_func(self, self->build_user_data);
+  }
+}
+
+void fl_menubar_lazy_menu_model_set_menu(FlMenubarLazyMenuModel* self,
+                                         GMenuModel* menu) {
+  g_return_if_fail(FL_IS_MENUBAR_LAZY_MENU_MODEL(self));
+  g_return_if_fail(self->menu == nullptr);
+
+  self->menu = G_MENU_MODEL(g_object_ref(menu));
+  g_signal_connect_object(menu, "items-changed", G_CALLBACK(items_changed_cb),
+                          self, static_cast<GConnectFlags>(0));
+  g_menu_model_items_changed(G_MENU_MODEL(self), 0, 0,
+                             g_menu_model_get_n_items(menu));
+}
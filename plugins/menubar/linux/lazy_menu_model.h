@@ -0,0 +1,64 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PLUGINS_MENUBAR_LINUX_LAZY_MENU_MODEL_H_
+#define PLUGINS_MENUBAR_LINUX_LAZY_MENU_MODEL_H_
+
+// A GMenuModel for a submenu whose items are only built when it is first
+// shown.
+//
+// GTK builds the widgets for a menu's submenus along with the menu, so the
+// model has no items until it is asked to build them. The submenu item should
+// have the "submenu-action" attribute set to the model's action name; GTK
+// changes the state of that action when the submenu is shown, and the model
+// then calls its build function, which provides the model with the real
+// items. From then on, the model mirrors that menu, including later changes
+// to it.
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE(FlMenubarLazyMenuModel, fl_menubar_lazy_menu_model, FL,
+                     MENUBAR_LAZY_MENU_MODEL, GMenuModel)
+
+// Called to build the items of |model|, which should be passed to
+// fl_menubar_lazy_menu_model_set_menu().
+typedef void (*FlMenubarLazyMenuModelBuildFunc)(
+    FlMenubarLazyMenuModel* model, gpointer user_data);
+
+// Creates a model with no items, adding its action to |application|.
+FlMenubarLazyMenuModel* fl_menubar_lazy_menu_model_new(
+    GtkApplication* application);
+
+// Sets the function to build the items when the submenu is shown, or clears
+// it if |build_func| is nullptr.
+void fl_menubar_lazy_menu_model_set_build_func(
+    FlMenubarLazyMenuModel* model, FlMenubarLazyMenuModelBuildFunc build_func,
+    gpointer user_data, GDestroyNotify destroy_notify);
+
+// Gets the detailed name of the action to use as the submenu item's
+// "submenu-action".
+const gchar* fl_menubar_lazy_menu_model_get_action_name(
+    FlMenubarLazyMenuModel* model);
+
+// Builds the items now if they haven't been already.
+void fl_menubar_lazy_menu_model_build(FlMenubarLazyMenuModel* model);
+
+// Sets the menu with the items for |model| to mirror.
+void fl_menubar_lazy_menu_model_set_menu(FlMenubarLazyMenuModel* model,
+                                         GMenuModel* menu);
+
+G_END_DECLS
+
+#endif  // PLUGINS_MENUBAR_LINUX_LAZY_MENU_MODEL_H_
@@ -17,18 +17,139 @@
 #include <flutter_linux/flutter_linux.h>
 #include <gtk/gtk.h>
 
+#include "lazy_menu_model.h"
+
 // See menu_channel.dart for documentation.
 const char kChannelName[] = "flutter/menubar";
 const char kBadArgumentsError[] = "Bad Arguments";
 const char kNoScreenError[] = "No Screen";
 const char kFailureError[] = "Failure";
 const char kMenuSetMethod[] = "Menubar.SetMenu";
+const char kMenuUpdateMethod[] = "Menubar.UpdateMenu";
+const char kMenuUpdateItemsMethod[] = "Menubar.UpdateItems";
 const char kMenuItemSelectedCallbackMethod[] = "Menubar.SelectedCallback";
+const char kGetStatsMethod[] = "Menubar.GetStats";
 const char kIdKey[] = "id";
 const char kLabelKey[] = "label";
 const char kEnabledKey[] = "enabled";
 const char kChildrenKey[] = "children";
 const char kIsDividerKey[] = "isDivider";
+const char kVisibleKey[] = "visible";
+const char kShortcutKeyEquivalent[] = "keyEquivalent";
+const char kShortcutSpecialKey[] = "specialKey";
+const char kShortcutKeyModifiers[] = "keyModifiers";
+const char kReuseHitsKey[] = "reuseHits";
+const char kReuseMissesKey[] = "reuseMisses";
+
+// Action activated by menu items, with the item id as target.
+const char kMenuActionName[] = "app.flutter-menu";
+
+// Values for kShortcutKeyModifiers.
+const int kShortcutModifierMeta = 1 << 0;
+const int kShortcutModifierShift = 1 << 1;
+const int kShortcutModifierAlt = 1 << 2;
+const int kShortcutModifierControl = 1 << 3;
+
+// Submenus with at least this many items are only built when first shown.
+// This saves building their GMenus and the retained model for them; each
+// Menubar.SetMenu or Menubar.UpdateMenu still hashes their items, see
+// set_lazy_value().
+const size_t kLazyMenuMinItems = 100;
+
+// FNV-1a parameters, used for structural hashes of menu lists.
+static const guint64 kHashOffsetBasis = 14695981039346656037ull;
+static const guint64 kHashPrime = 1099511628211ull;
+
+// Retained model of the menu last sent by Flutter. Each list of items is a
+// GMenu of sections, one for each run of items between dividers; submenu
+// items link to the GMenu of their child list. Updates are applied to this
+// model in place, so that GTK only sees the items that changed.
+typedef struct _MenuNode MenuNode;
+typedef struct _MenuList MenuList;
+
+// An item with an id in a submenu that hasn't been built yet, see
+// set_lazy_value().
+typedef struct {
+  gint64 id;
+
+  // GTK accelerator to register with the application for the item, see
+  // is_application_accel(), or nullptr if it has none.
+  gchar* accel;
+
+  gboolean enabled;
+} LazyItem;
+
+// A run of items between dividers.
+typedef struct {
+  // The list this group is in, see index_menu_list().
+  MenuList* list;
+
+  GMenu* section;
+
+  // MenuNode for each item in section, in order.
+  GPtrArray* nodes;
+} MenuGroup;
+
+// The items of a menu or submenu.
+struct _MenuList {
+  // The submenu item for this list, or nullptr for the top level. See
+  // index_menu_list().
+  MenuNode* parent;
+
+  // Menu containing a section for each group.
+  GMenu* menu;
+
+  // MenuGroup for each section in menu, in order.
+  GPtrArray* groups;
+
+  // Structural hash of the menu list value this list matches, see
+  // hash_menu_value(). Not set if the list hasn't been applied yet, or has
+  // since been changed by Menubar.UpdateItems.
+  gboolean has_hash;
+  guint64 hash;
+};
+
+struct _MenuNode {
+  // Identifies the item among its siblings across updates, see
+  // get_item_key().
+  gchar* key;
+
+  gchar* label;
+  gboolean has_id;
+  gint64 id;
+  gboolean enabled;
+
+  // GTK accelerator for the item's shortcut, or nullptr if it has none.
+  gchar* accel;
+
+  // Hidden items are kept in their group, but not in its section.
+  gboolean visible;
+
+  // Where the item is, see index_menu_list(): its group, and its position in
+  // the group's section (or where it would be, if hidden).
+  MenuGroup* group;
+  guint position;
+
+  // Child items if this is a submenu, otherwise nullptr.
+  MenuList* children;
+
+  // For a large submenu, the model the item links to, which only gets its
+  // items when first shown. Until then children is nullptr and lazy_value
+  // holds the items to build, with lazy_hash its hash_menu_value(), see
+  // set_lazy_value().
+  FlMenubarLazyMenuModel* lazy_menu;
+  FlValue* lazy_value;
+  guint64 lazy_hash;
+
+  // LazyItem by id for each item with an id in lazy_value, including in its
+  // submenus, and the ones of those with an accelerator.
+  GHashTable* lazy_items;
+  GHashTable* lazy_accels;
+
+  // Item update map by id for the items in lazy_value changed by
+  // Menubar.UpdateItems, applied once the submenu is built.
+  GHashTable* lazy_updates;
+};
 
 struct _FlMenubarPlugin {
   GObject parent_instance;
@@ -38,92 +159,1106 @@ struct _FlMenubarPlugin {
   // Connection to Flutter engine.
   FlMethodChannel* channel;
 
-  // Special handle used to indicate a divider.
-  GMenuItem* divider_item;
-
   // Menu being shown to the user.
   GMenu* menu;
+
+  // Retained model of the items in menu, or nullptr if no menu has been set.
+  MenuList* root;
+
+  // MenuNode by id for items in root with an id.
+  GHashTable* items_by_id;
+
+  // MenuNode for each submenu in root that hasn't been built yet.
+  GPtrArray* lazy_nodes;
+
+  // Accelerator by item id for the items with accelerators registered with
+  // the application.
+  GHashTable* accels;
+
+  // Number of menu lists that matched an existing list and so were reused,
+  // and number that had to be built or updated.
+  gint64 reuse_hits;
+  gint64 reuse_misses;
+};
+
+// A list in the previous menu that a new menu can take instead of building
+// an identical one.
+typedef struct _ReusableMenu ReusableMenu;
+struct _ReusableMenu {
+  // The submenu item that owns the list.
+  MenuNode* owner;
+
+  // The entry for the list containing owner, or nullptr for the top level.
+  ReusableMenu* parent;
+
+  // TRUE if the list has been taken, or if a list within it has been taken,
+  // in which case it can't be taken.
+  gboolean taken;
+  gboolean broken;
 };
 
+// A run of items between dividers in a menu list value, from start up to end.
+typedef struct {
+  size_t start;
+  size_t end;
+} MenuRun;
+
+// State for applying a menu list value.
+typedef struct {
+  // Structural hash of each menu list in the value, by FlValue.
+  GHashTable* hashes;
+
+  // ReusableMenu by structural hash, or nullptr if lists can't be taken.
+  GHashTable* reusable;
+
+  // Used to create lazily built submenus. If app is nullptr, all submenus
+  // are built immediately.
+  FlMenubarPlugin* plugin;
+  GtkApplication* app;
+
+  gint64 reuse_hits;
+  gint64 reuse_misses;
+} MenuBuild;
+
+// User data for build_lazy_menu_cb().
+typedef struct {
+  FlMenubarPlugin* plugin;
+  MenuNode* node;
+} LazyMenuBuild;
+
 G_DEFINE_TYPE(FlMenubarPlugin, fl_menubar_plugin, g_object_get_type())
 
-static GMenu* value_to_menu(FlMenubarPlugin* self, FlValue* value,
-                            GError** error);
+static void menu_list_free(MenuList* list);
 
-// Convert a value received from Flutter to a GtkMenuItem.
-static GMenuItem* value_to_menu_item(FlMenubarPlugin* self, FlValue* value,
-                                     GError** error) {
-  if (fl_value_get_type(value) != FL_VALUE_TYPE_MAP) {
-    g_set_error(error, 0, 0, "Menu item map missing or malformed");
-    return nullptr;
+// Clears the items of |node|'s submenu waiting to be built, if any.
+static void clear_lazy_value(MenuNode* node) {
+  g_clear_pointer(&node->lazy_value, fl_value_unref);
+  // lazy_items owns the keys of the other tables.
+  g_clear_pointer(&node->lazy_updates, g_hash_table_unref);
+  g_clear_pointer(&node->lazy_accels, g_hash_table_unref);
+  g_clear_pointer(&node->lazy_items, g_hash_table_unref);
+}
+
+// Removes the lazily built submenu from |node|, if any.
+static void clear_lazy_menu(MenuNode* node) {
+  if (node->lazy_menu != nullptr) {
+    fl_menubar_lazy_menu_model_set_build_func(node->lazy_menu, nullptr,
+                                              nullptr, nullptr);
+    g_clear_object(&node->lazy_menu);
   }
+  clear_lazy_value(node);
+}
 
+static void menu_node_free(MenuNode* node) {
+  g_free(node->key);
+  g_free(node->label);
+  g_free(node->accel);
+  g_clear_pointer(&node->children, menu_list_free);
+  clear_lazy_menu(node);
+  g_free(node);
+}
+
+static MenuGroup* menu_group_new() {
+  MenuGroup* group = g_new0(MenuGroup, 1);
+  group->section = g_menu_new();
+  group->nodes =
+      g_ptr_array_new_with_free_func(reinterpret_cast<GDestroyNotify>(
+          menu_node_free));
+  return group;
+}
+
+static void menu_group_free(MenuGroup* group) {
+  g_object_unref(group->section);
+  g_ptr_array_unref(group->nodes);
+  g_free(group);
+}
+
+static MenuList* menu_list_new() {
+  MenuList* list = g_new0(MenuList, 1);
+  list->menu = g_menu_new();
+  list->groups =
+      g_ptr_array_new_with_free_func(reinterpret_cast<GDestroyNotify>(
+          menu_group_free));
+  return list;
+}
+
+static void menu_list_free(MenuList* list) {
+  g_object_unref(list->menu);
+  g_ptr_array_unref(list->groups);
+  g_free(list);
+}
+
+// Returns TRUE if |value| is a menu item map for a divider.
+static gboolean is_divider_value(FlValue* value) {
   FlValue* is_divider_value = fl_value_lookup_string(value, kIsDividerKey);
-  if (is_divider_value != nullptr &&
-      fl_value_get_type(is_divider_value) == FL_VALUE_TYPE_BOOL &&
-      fl_value_get_bool(is_divider_value)) {
-    return G_MENU_ITEM(g_object_ref(self->divider_item));
-  }
+  return is_divider_value != nullptr &&
+         fl_value_get_type(is_divider_value) == FL_VALUE_TYPE_BOOL &&
+         fl_value_get_bool(is_divider_value);
+}
 
-  g_autoptr(GMenuItem) item = g_menu_item_new(nullptr, nullptr);
+// Gets the string for |key| in the item map |value|, or nullptr if it is
+// missing or not a string.
+static const gchar* lookup_string(FlValue* value, const gchar* key) {
+  FlValue* string_value = fl_value_lookup_string(value, key);
+  if (string_value == nullptr ||
+      fl_value_get_type(string_value) != FL_VALUE_TYPE_STRING) {
+    return nullptr;
+  }
+  return fl_value_get_string(string_value);
+}
 
+// Gets the key that identifies the item map |value| among its siblings. Items
+// with an id are identified by it, so they can be relabeled in place;
+// menu_channel.dart keeps an item's id across menus, so inserting an item
+// doesn't change the keys of the others. Others,
+// such as submenus, are identified by their label, with items of the same
+// label matched in order.
+static gchar* get_item_key(FlValue* value) {
   FlValue* id_value = fl_value_lookup_string(value, kIdKey);
-  if (id_value != nullptr && fl_value_get_type(id_value) == FL_VALUE_TYPE_INT) {
-    g_menu_item_set_action_and_target(item, "app.flutter-menu", "x",
-                                      fl_value_get_int(id_value));
+  if (id_value != nullptr &&
+      fl_value_get_type(id_value) == FL_VALUE_TYPE_INT) {
+    return g_strdup_printf("id:%" G_GINT64_FORMAT, fl_value_get_int(id_value));
   }
+  const gchar* label = lookup_string(value, kLabelKey);
+  return g_strconcat("label:", label != nullptr ? label : "", nullptr);
+}
 
-  FlValue* enabled_value = fl_value_lookup_string(value, kEnabledKey);
-  if (enabled_value != nullptr &&
-      fl_value_get_type(enabled_value) == FL_VALUE_TYPE_BOOL &&
-      !fl_value_get_bool(enabled_value))
+// Returns the GDK keyval for |special_key|, or 0 if it isn't known.
+// See _shortcutSpecialKeyValues in menu_channel.dart for values.
+static guint get_special_key_keyval(gint64 special_key) {
+  if (special_key >= 1 && special_key <= 12) {
+    return GDK_KEY_F1 + special_key - 1;
+  }
+  switch (special_key) {
+    case 13:
+      return GDK_KEY_BackSpace;
+    case 14:
+      return GDK_KEY_Delete;
+    default:
+      return 0;
+  }
+}
+
+// Gets the GTK accelerator for the shortcut in the item map |value|, or
+// nullptr if it has none or it can't be used as an accelerator.
+static gchar* get_item_accel(FlValue* value) {
+  guint keyval = 0;
+  const gchar* key_equivalent = lookup_string(value, kShortcutKeyEquivalent);
+  FlValue* special_key_value =
+      fl_value_lookup_string(value, kShortcutSpecialKey);
+  if (key_equivalent != nullptr && key_equivalent[0] != '\0') {
+    keyval = gdk_unicode_to_keyval(g_utf8_get_char(key_equivalent));
+  } else if (special_key_value != nullptr &&
+             fl_value_get_type(special_key_value) == FL_VALUE_TYPE_INT) {
+    keyval = get_special_key_keyval(fl_value_get_int(special_key_value));
+  }
+  if (keyval == 0) return nullptr;
+
+  FlValue* modifiers_value =
+      fl_value_lookup_string(value, kShortcutKeyModifiers);
+  gint64 modifiers = 0;
+  if (modifiers_value != nullptr &&
+      fl_value_get_type(modifiers_value) == FL_VALUE_TYPE_INT) {
+    modifiers = fl_value_get_int(modifiers_value);
+  }
+  int mask = 0;
+  if (modifiers & kShortcutModifierMeta) mask |= GDK_SUPER_MASK;
+  if (modifiers & kShortcutModifierShift) mask |= GDK_SHIFT_MASK;
+  if (modifiers & kShortcutModifierAlt) mask |= GDK_MOD1_MASK;
+  if (modifiers & kShortcutModifierControl) mask |= GDK_CONTROL_MASK;
+
+  GdkModifierType modifier_mask = static_cast<GdkModifierType>(mask);
+  if (!gtk_accelerator_valid(keyval, modifier_mask)) return nullptr;
+  return gtk_accelerator_name(keyval, modifier_mask);
+}
+
+// Returns TRUE if |accel| should be registered with the application, so that
+// it activates its item from anywhere in the window.
+//
+// Only shortcuts with a Control, Alt or Super modifier are registered. The
+// application's accelerators are handled before the key reaches Flutter, so
+// registering a shortcut such as Delete or a plain letter would stop that key
+// reaching text fields. Other shortcuts are still shown in the menu.
+static gboolean is_application_accel(const gchar* accel) {
+  guint keyval;
+  GdkModifierType mods;
+  gtk_accelerator_parse(accel, &keyval, &mods);
+  return (mods & (GDK_CONTROL_MASK | GDK_MOD1_MASK | GDK_SUPER_MASK)) != 0;
+}
+
+// Checks that a menu list received from Flutter is well formed, so that it
+// can be applied without failing part way through.
+static gboolean validate_menu_value(FlValue* value, GError** error) {
+  if (fl_value_get_type(value) != FL_VALUE_TYPE_LIST) {
+    g_set_error(error, 0, 0, "Menu list missing or malformed");
+    return FALSE;
+  }
+
+  for (size_t i = 0; i < fl_value_get_length(value); i++) {
+    FlValue* item = fl_value_get_list_value(value, i);
+    if (fl_value_get_type(item) != FL_VALUE_TYPE_MAP) {
+      g_set_error(error, 0, 0, "Menu item map missing or malformed");
+      return FALSE;
+    }
+    FlValue* children = fl_value_lookup_string(item, kChildrenKey);
+    if (!is_divider_value(item) && children != nullptr &&
+        !validate_menu_value(children, error)) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static guint64 hash_bytes(guint64 hash, const void* data, size_t length) {
+  const guint8* bytes = static_cast<const guint8*>(data);
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ bytes[i]) * kHashPrime;
+  }
+  return hash;
+}
+
+static guint64 hash_int(guint64 hash, gint64 value) {
+  return hash_bytes(hash, &value, sizeof(value));
+}
+
+// Adds the integer for |key| in the item map |item|, if any, to |hash|.
+static guint64 hash_optional_int(guint64 hash, FlValue* item,
+                                 const gchar* key) {
+  FlValue* value = fl_value_lookup_string(item, key);
+  gboolean has_value =
+      value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_INT;
+  hash = hash_int(hash, has_value);
+  return has_value ? hash_int(hash, fl_value_get_int(value)) : hash;
+}
+
+// Computes a hash of the menu list |value| from everything that affects the
+// menu built from it, and adds it and the hash of each submenu list in it to
+// |hashes|. |value| must have been checked with validate_menu_value().
+static guint64 hash_menu_value(FlValue* value, GHashTable* hashes) {
+  guint64 hash = kHashOffsetBasis;
+  for (size_t i = 0; i < fl_value_get_length(value); i++) {
+    FlValue* item = fl_value_get_list_value(value, i);
+    if (is_divider_value(item)) {
+      hash = hash_int(hash, 1);
+      continue;
+    }
+    hash = hash_int(hash, 2);
+
+    const gchar* label = lookup_string(item, kLabelKey);
+    hash = label != nullptr ? hash_bytes(hash, label, strlen(label) + 1)
+                            : hash_int(hash, 0);
+
+    FlValue* id_value = fl_value_lookup_string(item, kIdKey);
+    gboolean has_id = id_value != nullptr &&
+                      fl_value_get_type(id_value) == FL_VALUE_TYPE_INT;
+    hash = hash_int(hash, has_id);
+    if (has_id) hash = hash_int(hash, fl_value_get_int(id_value));
+
+    FlValue* enabled_value = fl_value_lookup_string(item, kEnabledKey);
+    gboolean enabled = enabled_value == nullptr ||
+                       fl_value_get_type(enabled_value) != FL_VALUE_TYPE_BOOL ||
+                       fl_value_get_bool(enabled_value);
+    hash = hash_int(hash, enabled);
+
+    const gchar* key_equivalent = lookup_string(item, kShortcutKeyEquivalent);
+    hash = key_equivalent != nullptr
+               ? hash_bytes(hash, key_equivalent, strlen(key_equivalent) + 1)
+               : hash_int(hash, 0);
+    hash = hash_optional_int(hash, item, kShortcutSpecialKey);
+    hash = hash_optional_int(hash, item, kShortcutKeyModifiers);
+
+    FlValue* children = fl_value_lookup_string(item, kChildrenKey);
+    hash = hash_int(hash, children != nullptr);
+    if (children != nullptr) {
+      hash = hash_int(hash, hash_menu_value(children, hashes));
+    }
+  }
+
+  guint64* stored_hash = g_new(guint64, 1);
+  *stored_hash = hash;
+  g_hash_table_insert(hashes, value, stored_hash);
+  return hash;
+}
+
+// Gets the hash of |value| computed by hash_menu_value().
+static guint64 get_menu_value_hash(MenuBuild* build, FlValue* value) {
+  return *static_cast<guint64*>(g_hash_table_lookup(build->hashes, value));
+}
+
+// Adds the submenu lists within |list| to |build| so they can be taken by
+// take_reusable_menu_list().
+static void add_reusable_menu_lists(MenuBuild* build, MenuList* list,
+                                    ReusableMenu* parent,
+                                    GPtrArray* entries) {
+  for (guint i = 0; i < list->groups->len; i++) {
+    MenuGroup* group =
+        static_cast<MenuGroup*>(g_ptr_array_index(list->groups, i));
+    for (guint j = 0; j < group->nodes->len; j++) {
+      MenuNode* node =
+          static_cast<MenuNode*>(g_ptr_array_index(group->nodes, j));
+      if (node->children == nullptr) continue;
+
+      ReusableMenu* entry = g_new0(ReusableMenu, 1);
+      entry->owner = node;
+      entry->parent = parent;
+      g_ptr_array_add(entries, entry);
+      // Of identical lists, the first one is taken.
+      if (node->children->has_hash &&
+          !g_hash_table_contains(build->reusable, &node->children->hash)) {
+        g_hash_table_insert(build->reusable, &node->children->hash, entry);
+      }
+      add_reusable_menu_lists(build, node->children, entry, entries);
+    }
+  }
+}
+
+// Takes the list with |hash| from the previous menu, or returns nullptr if
+// there is no such list.
+static MenuList* take_reusable_menu_list(MenuBuild* build, guint64 hash) {
+  if (build->reusable == nullptr) return nullptr;
+
+  ReusableMenu* entry =
+      static_cast<ReusableMenu*>(g_hash_table_lookup(build->reusable, &hash));
+  if (entry == nullptr) return nullptr;
+  g_hash_table_remove(build->reusable, &hash);
+
+  if (entry->taken || entry->broken) return nullptr;
+  for (ReusableMenu* p = entry->parent; p != nullptr; p = p->parent) {
+    if (p->taken) return nullptr;
+  }
+
+  entry->taken = TRUE;
+  for (ReusableMenu* p = entry->parent; p != nullptr; p = p->parent) {
+    p->broken = TRUE;
+  }
+  MenuList* list = entry->owner->children;
+  entry->owner->children = nullptr;
+  return list;
+}
+
+// Creates the GMenuItem shown for |node|.
+static GMenuItem* menu_node_to_item(MenuNode* node) {
+  GMenuItem* item = g_menu_item_new(nullptr, nullptr);
+
+  if (node->has_id) {
+    g_menu_item_set_action_and_target(item, kMenuActionName, "x", node->id);
+  }
+  if (!node->enabled) {
     g_menu_item_set_action_and_target(item, "app.flutter-menu-inactive",
                                       nullptr);
+  }
+  if (node->label != nullptr) g_menu_item_set_label(item, node->label);
+  if (node->accel != nullptr) {
+    g_menu_item_set_attribute(item, "accel", "s", node->accel);
+  }
+  if (node->lazy_menu != nullptr) {
+    g_menu_item_set_submenu(item, G_MENU_MODEL(node->lazy_menu));
+    g_menu_item_set_attribute(
+        item, "submenu-action", "s",
+        fl_menubar_lazy_menu_model_get_action_name(node->lazy_menu));
+  } else if (node->children != nullptr) {
+    g_menu_item_set_submenu(item, G_MENU_MODEL(node->children->menu));
+  }
+
+  return item;
+}
+
+// Inserts the GMenuItem for |node| into |group| at |position|.
+static void insert_menu_item(MenuGroup* group, guint position,
+                             MenuNode* node) {
+  g_autoptr(GMenuItem) item = menu_node_to_item(node);
+  g_menu_insert_item(group->section, position, item);
+}
+
+static void apply_menu_list(MenuList* list, FlValue* value,
+                            MenuBuild* build);
+
+static void build_lazy_menu_cb(FlMenubarLazyMenuModel* model,
+                               gpointer user_data);
+
+static void lazy_item_free(LazyItem* item) {
+  g_free(item->accel);
+  g_free(item);
+}
+
+// Adds a LazyItem to |node| for each item with an id in the menu list
+// |value|, including in its submenus.
+static void add_lazy_items(MenuNode* node, FlValue* value) {
+  for (size_t i = 0; i < fl_value_get_length(value); i++) {
+    FlValue* item = fl_value_get_list_value(value, i);
+    if (is_divider_value(item)) continue;
+
+    FlValue* id_value = fl_value_lookup_string(item, kIdKey);
+    gboolean has_id = id_value != nullptr &&
+                      fl_value_get_type(id_value) == FL_VALUE_TYPE_INT;
+    gint64 id = has_id ? fl_value_get_int(id_value) : 0;
+    // Ids are unique, but if not the first item is kept, as the tables share
+    // its key.
+    if (has_id && !g_hash_table_contains(node->lazy_items, &id)) {
+      FlValue* enabled_value = fl_value_lookup_string(item, kEnabledKey);
+      LazyItem* lazy_item = g_new0(LazyItem, 1);
+      lazy_item->id = id;
+      lazy_item->accel = get_item_accel(item);
+      if (lazy_item->accel != nullptr &&
+          !is_application_accel(lazy_item->accel)) {
+        g_clear_pointer(&lazy_item->accel, g_free);
+      }
+      lazy_item->enabled =
+          enabled_value == nullptr ||
+          fl_value_get_type(enabled_value) != FL_VALUE_TYPE_BOOL ||
+          fl_value_get_bool(enabled_value);
+      g_hash_table_insert(node->lazy_items, &lazy_item->id, lazy_item);
+      if (lazy_item->accel != nullptr) {
+        g_hash_table_insert(node->lazy_accels, &lazy_item->id, lazy_item);
+      }
+    }
+
+    FlValue* children = fl_value_lookup_string(item, kChildrenKey);
+    if (children != nullptr) add_lazy_items(node, children);
+  }
+}
+
+// Sets the items of |node|'s submenu to build when it is first shown, where
+// |hash| is the hash_menu_value() of |children|.
+//
+// The ids and accelerators of the items are indexed now, so that finding an
+// item or registering accelerators after each change to the menu doesn't need
+// to walk the items again. If the items haven't changed, the existing index
+// is kept, so setting the same menu again only walks them to hash them.
+// Changes from Menubar.UpdateItems to the previous items are dropped.
+static void set_lazy_value(MenuNode* node, FlValue* children, guint64 hash) {
+  if (node->lazy_value != nullptr && node->lazy_hash == hash) {
+    g_hash_table_remove_all(node->lazy_updates);
+    return;
+  }
+
+  clear_lazy_value(node);
+  node->lazy_hash = hash;
+  node->lazy_value = fl_value_ref(children);
+  node->lazy_items = g_hash_table_new_full(
+      g_int64_hash, g_int64_equal, nullptr,
+      reinterpret_cast<GDestroyNotify>(lazy_item_free));
+  node->lazy_accels = g_hash_table_new(g_int64_hash, g_int64_equal);
+  node->lazy_updates = g_hash_table_new_full(
+      g_int64_hash, g_int64_equal, nullptr,
+      reinterpret_cast<GDestroyNotify>(fl_value_unref));
+  add_lazy_items(node, children);
+}
+
+// Makes |node| a submenu of |children| that is built when first shown.
+static void make_lazy_menu(MenuNode* node, FlValue* children,
+                           MenuBuild* build) {
+  node->lazy_menu = fl_menubar_lazy_menu_model_new(build->app);
+  LazyMenuBuild* data = g_new(LazyMenuBuild, 1);
+  data->plugin = build->plugin;
+  data->node = node;
+  fl_menubar_lazy_menu_model_set_build_func(node->lazy_menu,
+                                            build_lazy_menu_cb, data, g_free);
+  set_lazy_value(node, children, get_menu_value_hash(build, children));
+}
 
-  FlValue* label_value = fl_value_lookup_string(value, kLabelKey);
-  if (label_value != nullptr &&
-      fl_value_get_type(label_value) == FL_VALUE_TYPE_STRING)
-    g_menu_item_set_label(item, fl_value_get_string(label_value));
+// Updates |node| to match the item map |value|. Returns TRUE if the node's
+// GMenuItem needs to be replaced; changes within a submenu are applied to its
+// child list directly.
+static gboolean apply_menu_node(MenuNode* node, FlValue* value,
+                                MenuBuild* build) {
+  gboolean changed = FALSE;
+
+  const gchar* label = lookup_string(value, kLabelKey);
+  if (g_strcmp0(label, node->label) != 0) {
+    g_free(node->label);
+    node->label = g_strdup(label);
+    changed = TRUE;
+  }
+
+  FlValue* id_value = fl_value_lookup_string(value, kIdKey);
+  gboolean has_id = id_value != nullptr &&
+                    fl_value_get_type(id_value) == FL_VALUE_TYPE_INT;
+  gint64 id = has_id ? fl_value_get_int(id_value) : 0;
+  if (has_id != node->has_id || id != node->id) {
+    node->has_id = has_id;
+    node->id = id;
+    changed = TRUE;
+  }
+
+  FlValue* enabled_value = fl_value_lookup_string(value, kEnabledKey);
+  gboolean enabled = enabled_value == nullptr ||
+                     fl_value_get_type(enabled_value) != FL_VALUE_TYPE_BOOL ||
+                     fl_value_get_bool(enabled_value);
+  if (enabled != node->enabled) {
+    node->enabled = enabled;
+    changed = TRUE;
+  }
+
+  g_autofree gchar* accel = get_item_accel(value);
+  if (g_strcmp0(accel, node->accel) != 0) {
+    g_free(node->accel);
+    node->accel = g_steal_pointer(&accel);
+    changed = TRUE;
+  }
 
   FlValue* children = fl_value_lookup_string(value, kChildrenKey);
-  if (children != nullptr) {
-    g_autoptr(GMenu) sub_menu = value_to_menu(self, children, error);
-    if (sub_menu == nullptr) return nullptr;
+  if (children == nullptr) {
+    if (node->children != nullptr || node->lazy_menu != nullptr) {
+      g_clear_pointer(&node->children, menu_list_free);
+      clear_lazy_menu(node);
+      changed = TRUE;
+    }
+  } else if (node->lazy_menu != nullptr && node->children == nullptr) {
+    // Not shown yet, so just keep the new items for when it is.
+    set_lazy_value(node, children, get_menu_value_hash(build, children));
+  } else {
+    if (node->children == nullptr) {
+      node->children = take_reusable_menu_list(
+          build, get_menu_value_hash(build, children));
+      changed = TRUE;
+    }
+    if (node->children == nullptr && build->app != nullptr &&
+        fl_value_get_length(children) >= kLazyMenuMinItems) {
+      make_lazy_menu(node, children, build);
+    } else {
+      if (node->children == nullptr) node->children = menu_list_new();
+      apply_menu_list(node->children, children, build);
+    }
+  }
+
+  return changed;
+}
+
+// Removes the item at |position| in |group|.
+static void remove_menu_node(MenuGroup* group, guint position) {
+  g_menu_remove(group->section, position);
+  g_ptr_array_remove_index(group->nodes, position);
+}
+
+// Updates |group| to match the items of |value| from |start| to |end|,
+// matching items to existing nodes by key. |keys| has the key of each item in
+// |value|, see get_item_key().
+static void apply_menu_group(MenuGroup* group, FlValue* value,
+                             GPtrArray* keys, size_t start, size_t end,
+                             MenuBuild* build) {
+  guint n_items = end - start;
+
+  // Items hidden by Menubar.UpdateItems are shown again, since the new items
+  // describe the whole menu.
+  guint section_position = 0;
+  for (guint i = 0; i < group->nodes->len; i++) {
+    MenuNode* node =
+        static_cast<MenuNode*>(g_ptr_array_index(group->nodes, i));
+    if (!node->visible) {
+      node->visible = TRUE;
+      insert_menu_item(group, section_position, node);
+    }
+    section_position++;
+  }
 
-    g_menu_item_set_submenu(item, G_MENU_MODEL(sub_menu));
+  // Remove items that are no longer present.
+  g_autoptr(GHashTable) present_keys =
+      g_hash_table_new(g_str_hash, g_str_equal);
+  for (size_t i = start; i < end; i++) {
+    g_hash_table_add(present_keys, g_ptr_array_index(keys, i));
   }
+  for (guint i = group->nodes->len; i-- > 0;) {
+    MenuNode* node =
+        static_cast<MenuNode*>(g_ptr_array_index(group->nodes, i));
+    if (!g_hash_table_contains(present_keys, node->key)) {
+      remove_menu_node(group, i);
+    }
+  }
+
+  for (guint position = 0; position < n_items; position++) {
+    FlValue* item = fl_value_get_list_value(value, start + position);
+    const gchar* key =
+        static_cast<const gchar*>(g_ptr_array_index(keys, start + position));
+
+    // Find the first unmatched node with this key.
+    guint index = position;
+    while (index < group->nodes->len &&
+           strcmp(static_cast<MenuNode*>(
+                      g_ptr_array_index(group->nodes, index))
+                      ->key,
+                  key) != 0) {
+      index++;
+    }
 
-  return G_MENU_ITEM(g_object_ref(item));
+    if (index == group->nodes->len) {
+      MenuNode* node = g_new0(MenuNode, 1);
+      node->key = g_strdup(key);
+      node->visible = TRUE;
+      apply_menu_node(node, item, build);
+      g_ptr_array_insert(group->nodes, position, node);
+      insert_menu_item(group, position, node);
+      continue;
+    }
+
+    MenuNode* node =
+        static_cast<MenuNode*>(g_ptr_array_index(group->nodes, index));
+    gboolean changed = apply_menu_node(node, item, build);
+    if (index != position) {
+      // Move the node, keeping any submenu it links to.
+      g_menu_remove(group->section, index);
+      g_ptr_array_steal_index(group->nodes, index);
+      g_ptr_array_insert(group->nodes, position, node);
+      insert_menu_item(group, position, node);
+    } else if (changed) {
+      g_menu_remove(group->section, position);
+      insert_menu_item(group, position, node);
+    }
+  }
+
+  // Remove surplus items with duplicate keys.
+  while (group->nodes->len > n_items) {
+    remove_menu_node(group, group->nodes->len - 1);
+  }
 }
 
-// Convert a value received from Flutter to a GtkMenuItem.
-static GMenu* value_to_menu(FlMenubarPlugin* self, FlValue* value,
-                            GError** error) {
-  if (fl_value_get_type(value) != FL_VALUE_TYPE_LIST) {
-    g_set_error(error, 0, 0, "Menu list missing or malformed");
+// Updates |list| to match the menu list |value|, which must have been checked
+// with validate_menu_value() and hashed into |build|. A list that already
+// matches is left untouched.
+static void apply_menu_list(MenuList* list, FlValue* value,
+                            MenuBuild* build) {
+  guint64 hash = get_menu_value_hash(build, value);
+  if (list->has_hash && list->hash == hash) {
+    build->reuse_hits++;
+    return;
+  }
+  build->reuse_misses++;
+
+  // Items between dividers are grouped into sections. Leading, trailing and
+  // repeated dividers don't make empty sections.
+  size_t length = fl_value_get_length(value);
+  g_autoptr(GPtrArray) keys = g_ptr_array_new_full(length, g_free);
+  g_autoptr(GArray) runs = g_array_new(FALSE, FALSE, sizeof(MenuRun));
+  for (size_t i = 0; i < length; i++) {
+    FlValue* item = fl_value_get_list_value(value, i);
+    gboolean is_divider = is_divider_value(item);
+    g_ptr_array_add(keys, is_divider ? nullptr : get_item_key(item));
+    if (is_divider) continue;
+    if (i == 0 || g_ptr_array_index(keys, i - 1) == nullptr) {
+      MenuRun run = {i, i};
+      g_array_append_val(runs, run);
+    }
+    g_array_index(runs, MenuRun, runs->len - 1).end = i + 1;
+  }
+
+  // Match each run to an existing group that has one of its items, so
+  // that adding, removing or moving a section doesn't rebuild the others.
+  g_autoptr(GHashTable) groups_by_key =
+      g_hash_table_new(g_str_hash, g_str_equal);
+  for (guint i = 0; i < list->groups->len; i++) {
+    MenuGroup* group =
+        static_cast<MenuGroup*>(g_ptr_array_index(list->groups, i));
+    for (guint j = 0; j < group->nodes->len; j++) {
+      MenuNode* node =
+          static_cast<MenuNode*>(g_ptr_array_index(group->nodes, j));
+      if (!g_hash_table_contains(groups_by_key, node->key)) {
+        g_hash_table_insert(groups_by_key, node->key, group);
+      }
+    }
+  }
+  g_autoptr(GHashTable) matched_groups =
+      g_hash_table_new(g_direct_hash, g_direct_equal);
+  g_autofree MenuGroup** run_groups = g_new0(MenuGroup*, MAX(runs->len, 1));
+  for (guint i = 0; i < runs->len; i++) {
+    MenuRun* run = &g_array_index(runs, MenuRun, i);
+    for (size_t j = run->start; j < run->end; j++) {
+      MenuGroup* group = static_cast<MenuGroup*>(
+          g_hash_table_lookup(groups_by_key, g_ptr_array_index(keys, j)));
+      if (group != nullptr && !g_hash_table_contains(matched_groups, group)) {
+        g_hash_table_add(matched_groups, group);
+        run_groups[i] = group;
+        break;
+      }
+    }
+  }
+
+  // Node keys in groups_by_key are freed as groups are changed below.
+  g_hash_table_remove_all(groups_by_key);
+  for (guint i = list->groups->len; i-- > 0;) {
+    if (!g_hash_table_contains(matched_groups,
+                               g_ptr_array_index(list->groups, i))) {
+      g_menu_remove(list->menu, i);
+      g_ptr_array_remove_index(list->groups, i);
+    }
+  }
+
+  for (guint i = 0; i < runs->len; i++) {
+    MenuRun* run = &g_array_index(runs, MenuRun, i);
+    MenuGroup* group = run_groups[i];
+    if (group == nullptr) {
+      // Fill new sections before adding them, so they are added in one
+      // change.
+      group = menu_group_new();
+      apply_menu_group(group, value, keys, run->start, run->end, build);
+      g_ptr_array_insert(list->groups, i, group);
+      g_menu_insert_section(list->menu, i, nullptr,
+                            G_MENU_MODEL(group->section));
+      continue;
+    }
+
+    apply_menu_group(group, value, keys, run->start, run->end, build);
+    // Groups before i are in place, so a matched group is at i or later.
+    guint index = i;
+    while (g_ptr_array_index(list->groups, index) != group) index++;
+    if (index != i) {
+      g_menu_remove(list->menu, index);
+      g_ptr_array_steal_index(list->groups, index);
+      g_ptr_array_insert(list->groups, i, group);
+      g_menu_insert_section(list->menu, i, nullptr,
+                            G_MENU_MODEL(group->section));
+    }
+  }
+
+  list->hash = hash;
+  list->has_hash = TRUE;
+}
+
+// Updates the position of each item in |group|.
+static void index_menu_group(MenuGroup* group) {
+  guint position = 0;
+  for (guint i = 0; i < group->nodes->len; i++) {
+    MenuNode* node =
+        static_cast<MenuNode*>(g_ptr_array_index(group->nodes, i));
+    node->group = group;
+    node->position = position;
+    if (node->visible) position++;
+  }
+}
+
+// Records where each item in |list| is, adds the items with ids to
+// |items_by_id|, and adds submenus that haven't been built to |lazy_nodes|.
+// |parent| is the submenu item for |list|, if any.
+static void index_menu_list(MenuList* list, MenuNode* parent,
+                            GHashTable* items_by_id, GPtrArray* lazy_nodes) {
+  list->parent = parent;
+  for (guint i = 0; i < list->groups->len; i++) {
+    MenuGroup* group =
+        static_cast<MenuGroup*>(g_ptr_array_index(list->groups, i));
+    group->list = list;
+    index_menu_group(group);
+    for (guint j = 0; j < group->nodes->len; j++) {
+      MenuNode* node =
+          static_cast<MenuNode*>(g_ptr_array_index(group->nodes, j));
+      if (node->has_id) g_hash_table_insert(items_by_id, &node->id, node);
+      if (node->children != nullptr) {
+        index_menu_list(node->children, node, items_by_id, lazy_nodes);
+      } else if (node->lazy_value != nullptr) {
+        g_ptr_array_add(lazy_nodes, node);
+      }
+    }
+  }
+}
+
+// Gets the accelerator that should activate |node|, or nullptr if none
+// should. Shortcuts of disabled and hidden items don't do anything.
+static const gchar* get_node_accel(MenuNode* node) {
+  if (!node->has_id || !node->enabled || !node->visible ||
+      node->accel == nullptr || !is_application_accel(node->accel)) {
     return nullptr;
   }
+  return node->accel;
+}
+
+// Registers |accel| with |app| for the item with |id|, or unregisters the
+// item's accelerator if |accel| is nullptr.
+static void update_item_accel(FlMenubarPlugin* self, GtkApplication* app,
+                              gint64 id, const gchar* accel) {
+  if (g_strcmp0(accel, static_cast<const gchar*>(
+                           g_hash_table_lookup(self->accels, &id))) == 0) {
+    return;
+  }
+
+  g_autoptr(GVariant) target = g_variant_ref_sink(g_variant_new_int64(id));
+  g_autofree gchar* action_name =
+      g_action_print_detailed_name(kMenuActionName, target);
+  const gchar* accels[] = {accel, nullptr};
+  gtk_application_set_accels_for_action(app, action_name, accels);
 
-  g_autoptr(GMenu) menu = g_menu_new();
-  g_autoptr(GMenu) section = nullptr;
+  if (accel != nullptr) {
+    gint64* key = g_new(gint64, 1);
+    *key = id;
+    g_hash_table_insert(self->accels, key, g_strdup(accel));
+  } else {
+    g_hash_table_remove(self->accels, &id);
+  }
+}
+
+// Gets the accelerator that should activate |item| in |node|'s submenu, or
+// nullptr if none should, taking changes waiting for the submenu to be built
+// into account. See get_node_accel().
+static const gchar* get_lazy_item_accel(MenuNode* node, LazyItem* item) {
+  if (item->accel == nullptr) return nullptr;
+
+  gboolean enabled = item->enabled;
+  gboolean visible = TRUE;
+  FlValue* update =
+      static_cast<FlValue*>(g_hash_table_lookup(node->lazy_updates, &item->id));
+  if (update != nullptr) {
+    FlValue* enabled_value = fl_value_lookup_string(update, kEnabledKey);
+    if (enabled_value != nullptr) enabled = fl_value_get_bool(enabled_value);
+    FlValue* visible_value = fl_value_lookup_string(update, kVisibleKey);
+    if (visible_value != nullptr) visible = fl_value_get_bool(visible_value);
+  }
+  return enabled && visible ? item->accel : nullptr;
+}
+
+// Returns TRUE if |id| has an accelerator in a submenu in |lazy_nodes| that
+// hasn't been built.
+static gboolean lazy_nodes_have_accel(GPtrArray* lazy_nodes, gint64 id) {
+  for (guint i = 0; i < lazy_nodes->len; i++) {
+    MenuNode* node = static_cast<MenuNode*>(g_ptr_array_index(lazy_nodes, i));
+    if (g_hash_table_contains(node->lazy_accels, &id)) return TRUE;
+  }
+  return FALSE;
+}
+
+// Registers the accelerators for the items in |self->items_by_id| and in
+// |self->lazy_nodes| with |app|, unregistering any for items no longer in the
+// menu.
+static void update_accels(FlMenubarPlugin* self, GtkApplication* app) {
+  g_autoptr(GArray) removed_ids = g_array_new(FALSE, FALSE, sizeof(gint64));
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, self->accels);
+  while (g_hash_table_iter_next(&iter, &key, nullptr)) {
+    gint64 id = *static_cast<gint64*>(key);
+    if (!g_hash_table_contains(self->items_by_id, &id) &&
+        !lazy_nodes_have_accel(self->lazy_nodes, id)) {
+      g_array_append_val(removed_ids, id);
+    }
+  }
+  for (guint i = 0; i < removed_ids->len; i++) {
+    update_item_accel(self, app, g_array_index(removed_ids, gint64, i),
+                      nullptr);
+  }
+
+  g_hash_table_iter_init(&iter, self->items_by_id);
+  while (g_hash_table_iter_next(&iter, nullptr, &value)) {
+    MenuNode* node = static_cast<MenuNode*>(value);
+    update_item_accel(self, app, node->id, get_node_accel(node));
+  }
+
+  // Shortcuts for items in submenus that haven't been built work too.
+  for (guint i = 0; i < self->lazy_nodes->len; i++) {
+    MenuNode* node =
+        static_cast<MenuNode*>(g_ptr_array_index(self->lazy_nodes, i));
+    g_hash_table_iter_init(&iter, node->lazy_accels);
+    while (g_hash_table_iter_next(&iter, nullptr, &value)) {
+      LazyItem* item = static_cast<LazyItem*>(value);
+      update_item_accel(self, app, item->id, get_lazy_item_accel(node, item));
+    }
+  }
+}
+
+// Gets the application the Flutter view is in, or nullptr if there is none.
+static GtkApplication* get_application(FlMenubarPlugin* self) {
+  FlView* view = fl_plugin_registrar_get_view(self->registrar);
+  if (view == nullptr) return nullptr;
+  return gtk_window_get_application(
+      GTK_WINDOW(gtk_widget_get_toplevel(GTK_WIDGET(view))));
+}
+
+// Rebuilds the indexes of the items in the menu, and registers their
+// accelerators with |app| if not nullptr.
+static void index_menu(FlMenubarPlugin* self, GtkApplication* app) {
+  g_hash_table_remove_all(self->items_by_id);
+  g_ptr_array_set_size(self->lazy_nodes, 0);
+  index_menu_list(self->root, nullptr, self->items_by_id, self->lazy_nodes);
+  if (app != nullptr) update_accels(self, app);
+}
+
+static void apply_item_update(FlMenubarPlugin* self, gint64 id,
+                              FlValue* value);
+
+// Builds the items of a lazily built submenu when it is first shown.
+static void build_lazy_menu_cb(FlMenubarLazyMenuModel* model,
+                               gpointer user_data) {
+  LazyMenuBuild* data = static_cast<LazyMenuBuild*>(user_data);
+  FlMenubarPlugin* self = data->plugin;
+  MenuNode* node = data->node;
+
+  MenuBuild build = {};
+  g_autoptr(GHashTable) hashes =
+      g_hash_table_new_full(g_direct_hash, g_direct_equal, nullptr, g_free);
+  build.hashes = hashes;
+  build.plugin = self;
+  build.app = get_application(self);
+  hash_menu_value(node->lazy_value, hashes);
+
+  node->children = menu_list_new();
+  apply_menu_list(node->children, node->lazy_value, &build);
+  GHashTable* updates = g_steal_pointer(&node->lazy_updates);
+  self->reuse_hits += build.reuse_hits;
+  self->reuse_misses += build.reuse_misses;
+
+  fl_menubar_lazy_menu_model_set_menu(model,
+                                      G_MENU_MODEL(node->children->menu));
+  index_menu(self, build.app);
+
+  // Apply the changes made while the submenu wasn't built. Those to items in
+  // submenus within it that still aren't built are passed on to them.
+  GHashTableIter iter;
+  gpointer key;
+  gpointer value;
+  g_hash_table_iter_init(&iter, updates);
+  while (g_hash_table_iter_next(&iter, &key, &value)) {
+    apply_item_update(self, *static_cast<gint64*>(key),
+                      static_cast<FlValue*>(value));
+  }
+  g_hash_table_unref(updates);
+  clear_lazy_value(node);
+}
+
+// Gets the submenu that hasn't been built yet containing the item with |id|,
+// or nullptr if there is no such submenu.
+static MenuNode* find_lazy_node_with_id(FlMenubarPlugin* self, gint64 id) {
+  for (guint i = 0; i < self->lazy_nodes->len; i++) {
+    MenuNode* node =
+        static_cast<MenuNode*>(g_ptr_array_index(self->lazy_nodes, i));
+    if (g_hash_table_contains(node->lazy_items, &id)) return node;
+  }
+  return nullptr;
+}
+
+// Marks the lists containing |node| as no longer matching the value they were
+// built from.
+static void invalidate_menu_hashes(MenuNode* node) {
+  // Lists above an invalidated list are always invalidated too.
+  for (MenuList* list = node->group->list; list != nullptr && list->has_hash;
+       list = list->parent != nullptr ? list->parent->group->list : nullptr) {
+    list->has_hash = FALSE;
+  }
+}
+
+// Changes one item in place, as described by the item update map |value|,
+// which must have been checked by update_items().
+static void update_item(FlMenubarPlugin* self, MenuNode* node,
+                        FlValue* value) {
+  gboolean was_visible = node->visible;
+  gboolean changed = FALSE;
+  const gchar* label = lookup_string(value, kLabelKey);
+  if (label != nullptr && g_strcmp0(label, node->label) != 0) {
+    g_free(node->label);
+    node->label = g_strdup(label);
+    changed = TRUE;
+  }
+  FlValue* enabled_value = fl_value_lookup_string(value, kEnabledKey);
+  if (enabled_value != nullptr &&
+      fl_value_get_bool(enabled_value) != node->enabled) {
+    node->enabled = fl_value_get_bool(enabled_value);
+    changed = TRUE;
+  }
+  FlValue* visible_value = fl_value_lookup_string(value, kVisibleKey);
+  if (visible_value != nullptr) {
+    node->visible = fl_value_get_bool(visible_value);
+  }
+  if (!changed && node->visible == was_visible) return;
+  invalidate_menu_hashes(node);
+
+  MenuGroup* group = node->group;
+  if (was_visible) g_menu_remove(group->section, node->position);
+  if (node->visible) insert_menu_item(group, node->position, node);
+
+  // Only showing or hiding an item moves the items after it.
+  if (node->visible != was_visible) index_menu_group(group);
+
+  GtkApplication* app = get_application(self);
+  if (app != nullptr) {
+    update_item_accel(self, app, node->id, get_node_accel(node));
+  }
+}
+
+// Records the item update map |value| for the item with |id| in |node|'s
+// submenu, which hasn't been built, to apply once it is.
+static void update_lazy_item(FlMenubarPlugin* self, MenuNode* node, gint64 id,
+                             FlValue* value) {
+  LazyItem* item =
+      static_cast<LazyItem*>(g_hash_table_lookup(node->lazy_items, &id));
+  FlValue* pending =
+      static_cast<FlValue*>(g_hash_table_lookup(node->lazy_updates, &id));
+  if (pending == nullptr) {
+    pending = fl_value_new_map();
+    g_hash_table_insert(node->lazy_updates, &item->id, pending);
+  }
+  // Later changes to a field replace earlier ones.
   for (size_t i = 0; i < fl_value_get_length(value); i++) {
-    g_autoptr(GMenuItem) item =
-        value_to_menu_item(self, fl_value_get_list_value(value, i), error);
-    if (item == nullptr) return nullptr;
-
-    if (item == self->divider_item) {
-      if (section != nullptr)
-        g_menu_append_section(menu, nullptr, G_MENU_MODEL(section));
-      g_clear_object(&section);
-    } else {
-      if (section == nullptr) section = g_menu_new();
-      g_menu_append_item(section, item);
+    fl_value_set(pending, fl_value_get_map_key(value, i),
+                 fl_value_get_map_value(value, i));
+  }
+
+  GtkApplication* app = get_application(self);
+  if (app != nullptr) {
+    update_item_accel(self, app, id, get_lazy_item_accel(node, item));
+  }
+}
+
+// Changes the item with |id| as described by the item update map |value|,
+// which must have been checked by update_items(). Items in submenus that
+// haven't been built are changed once they are, without building them now.
+static void apply_item_update(FlMenubarPlugin* self, gint64 id,
+                              FlValue* value) {
+  MenuNode* node =
+      static_cast<MenuNode*>(g_hash_table_lookup(self->items_by_id, &id));
+  if (node != nullptr) {
+    update_item(self, node, value);
+    return;
+  }
+  MenuNode* lazy_node = find_lazy_node_with_id(self, id);
+  if (lazy_node != nullptr) update_lazy_item(self, lazy_node, id, value);
+}
+
+// Changes individual items of the menu, addressed by id.
+static FlMethodResponse* update_items(FlMenubarPlugin* self, FlValue* args) {
+  if (fl_value_get_type(args) != FL_VALUE_TYPE_LIST) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected list of item updates", nullptr));
+  }
+
+  // Check everything first, so that either all updates apply or none do.
+  size_t n_updates = fl_value_get_length(args);
+  for (size_t i = 0; i < n_updates; i++) {
+    FlValue* update = fl_value_get_list_value(args, i);
+    FlValue* id_value = nullptr;
+    FlValue* label_value = nullptr;
+    FlValue* enabled_value = nullptr;
+    FlValue* visible_value = nullptr;
+    if (fl_value_get_type(update) == FL_VALUE_TYPE_MAP) {
+      id_value = fl_value_lookup_string(update, kIdKey);
+      label_value = fl_value_lookup_string(update, kLabelKey);
+      enabled_value = fl_value_lookup_string(update, kEnabledKey);
+      visible_value = fl_value_lookup_string(update, kVisibleKey);
+    }
+    if (id_value == nullptr ||
+        fl_value_get_type(id_value) != FL_VALUE_TYPE_INT ||
+        (label_value != nullptr &&
+         fl_value_get_type(label_value) != FL_VALUE_TYPE_STRING) ||
+        (enabled_value != nullptr &&
+         fl_value_get_type(enabled_value) != FL_VALUE_TYPE_BOOL) ||
+        (visible_value != nullptr &&
+         fl_value_get_type(visible_value) != FL_VALUE_TYPE_BOOL)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Item update map missing or malformed",
+          nullptr));
     }
+
+    gint64 id = fl_value_get_int(id_value);
+    if (!g_hash_table_contains(self->items_by_id, &id) &&
+        find_lazy_node_with_id(self, id) == nullptr) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Unknown menu item id", nullptr));
+    }
+  }
+
+  for (size_t i = 0; i < n_updates; i++) {
+    FlValue* update = fl_value_get_list_value(args, i);
+    apply_item_update(
+        self, fl_value_get_int(fl_value_lookup_string(update, kIdKey)),
+        update);
   }
-  if (section != nullptr)
-    g_menu_append_section(menu, nullptr, G_MENU_MODEL(section));
 
-  return G_MENU(g_object_ref(menu));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
 // Called when a menu item is activated.
@@ -136,11 +1271,11 @@ static void menu_activate_cb(FlMenubarPlugin* self, GVariant* parameter) {
                                   nullptr, nullptr, nullptr);
 }
 
-// Sets the menu.
-static FlMethodResponse* menu_set(FlMenubarPlugin* self, FlValue* args) {
+// Sets the menu, or updates the existing one to match if |update| is TRUE.
+static FlMethodResponse* menu_set(FlMenubarPlugin* self, FlValue* args,
+                                  gboolean update) {
   g_autoptr(GError) error = nullptr;
-  g_autoptr(GMenu) menu = value_to_menu(self, args, &error);
-  if (menu == nullptr) {
+  if (!validate_menu_value(args, &error)) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new(
         kBadArgumentsError, error->message, nullptr));
   }
@@ -158,13 +1293,53 @@ static FlMethodResponse* menu_set(FlMenubarPlugin* self, FlValue* args) {
         kFailureError, "Unable to get application", nullptr));
   }
 
-  // Replace existing menu with this one
-  g_menu_remove_all(self->menu);
-  g_menu_append_section(self->menu, nullptr, G_MENU_MODEL(menu));
+  MenuBuild build = {};
+  g_autoptr(GHashTable) hashes =
+      g_hash_table_new_full(g_direct_hash, g_direct_equal, nullptr, g_free);
+  build.hashes = hashes;
+  build.plugin = self;
+  build.app = app;
+  guint64 hash = hash_menu_value(args, hashes);
+
+  if (self->root != nullptr &&
+      (update || (self->root->has_hash && self->root->hash == hash))) {
+    apply_menu_list(self->root, args, &build);
+  } else {
+    // Replace existing menu with this one, taking any submenus that haven't
+    // changed from the existing one.
+    g_autoptr(GHashTable) reusable =
+        g_hash_table_new(g_int64_hash, g_int64_equal);
+    g_autoptr(GPtrArray) entries = g_ptr_array_new_with_free_func(g_free);
+    if (self->root != nullptr) {
+      build.reusable = reusable;
+      add_reusable_menu_lists(&build, self->root, nullptr, entries);
+    }
+
+    MenuList* root = menu_list_new();
+    apply_menu_list(root, args, &build);
+    g_menu_remove_all(self->menu);
+    g_menu_append_section(self->menu, nullptr, G_MENU_MODEL(root->menu));
+    g_clear_pointer(&self->root, menu_list_free);
+    self->root = root;
+  }
+  self->reuse_hits += build.reuse_hits;
+  self->reuse_misses += build.reuse_misses;
+
+  index_menu(self, app);
 
   return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
+// Gets counters for how often menu lists are reused.
+static FlMethodResponse* get_stats(FlMenubarPlugin* self) {
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, kReuseHitsKey,
+                           fl_value_new_int(self->reuse_hits));
+  fl_value_set_string_take(result, kReuseMissesKey,
+                           fl_value_new_int(self->reuse_misses));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
 // Called when a method call is received from Flutter.
 static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
                            gpointer user_data) {
@@ -175,7 +1350,13 @@ static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
 
   g_autoptr(FlMethodResponse) response = nullptr;
   if (strcmp(method, kMenuSetMethod) == 0) {
-    response = menu_set(self, args);
+    response = menu_set(self, args, FALSE);
+  } else if (strcmp(method, kMenuUpdateMethod) == 0) {
+    response = menu_set(self, args, TRUE);
+  } else if (strcmp(method, kMenuUpdateItemsMethod) == 0) {
+    response = update_items(self, args);
+  } else if (strcmp(method, kGetStatsMethod) == 0) {
+    response = get_stats(self);
   } else {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
   }
@@ -190,8 +1371,11 @@ static void fl_menubar_plugin_dispose(GObject* object) {
 
   g_clear_object(&self->registrar);
   g_clear_object(&self->channel);
+  g_clear_pointer(&self->items_by_id, g_hash_table_unref);
+  g_clear_pointer(&self->accels, g_hash_table_unref);
+  g_clear_pointer(&self->lazy_nodes, g_ptr_array_unref);
+  g_clear_pointer(&self->root, menu_list_free);
   g_clear_object(&self->menu);
-  g_clear_object(&self->divider_item);
 
   G_OBJECT_CLASS(fl_menubar_plugin_parent_class)->dispose(object);
 }
@@ -201,7 +1385,10 @@ static void fl_menubar_plugin_class_init(FlMenubarPluginClass* klass) {
 }
 
 static void fl_menubar_plugin_init(FlMenubarPlugin* self) {
-  self->divider_item = g_menu_item_new(nullptr, nullptr);
+  self->items_by_id = g_hash_table_new(g_int64_hash, g_int64_equal);
+  self->lazy_nodes = g_ptr_array_new();
+  self->accels =
+      g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, g_free);
 }
 
 FlMenubarPlugin* fl_menubar_plugin_new(FlPluginRegistrar* registrar) {
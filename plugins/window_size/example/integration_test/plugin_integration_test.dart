@@ -12,11 +12,23 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter/material.dart';
+import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
 import 'package:integration_test/integration_test.dart';
 
 import 'package:window_size/window_size.dart';
 
+// The headless test runs when the app is run without a view on Linux, with
+// WINDOW_SIZE_VIRTUAL_DISPLAY set to the path of virtual_display.ini, so that
+// the plugin uses that model instead of a real display.
+final bool headless = Platform.isLinux &&
+    (Platform.environment['WINDOW_SIZE_VIRTUAL_DISPLAY'] ?? '')
+        .endsWith('virtual_display.ini');
+
 void main() {
   IntegrationTestWidgetsFlutterBinding.ensureInitialized();
 
@@ -26,4 +38,135 @@ void main() {
     expect(windowInfo.scaleFactor > 0, isTrue);
     expect(windowInfo.screen, isNotNull);
   });
+
+  testWidgets('classifyRects finds the screen a rect is on', (tester) async {
+    final screens = await getScreenList();
+    final frame = screens[0].frame;
+    final inside = Rect.fromCenter(
+        center: frame.center, width: frame.width / 4, height: frame.height / 4);
+    final offScreen = const Rect.fromLTWH(-1e6, -1e6, 10, 10);
+
+    final classifications = await classifyRects([inside, offScreen]);
+
+    expect(classifications, hasLength(2));
+    // Of overlapping screens, such as mirrored ones, the first is chosen.
+    expect(classifications[0].screenIndex, 0);
+    expect(classifications[0].overlaps, hasLength(screens.length));
+    expect(classifications[0].overlaps[0], closeTo(1, 1e-9));
+    expect(classifications[1].screenIndex, -1);
+    expect(classifications[1].overlaps, everyElement(0));
+  }, skip: !Platform.isLinux);
+
+  testWidgets('windowId routes calls to that window', (tester) async {
+    final ids = await getWindowList();
+    final windowInfo = await getWindowInfo();
+    expect(ids, contains(windowInfo.windowId));
+
+    final byId = await getWindowInfo(windowId: windowInfo.windowId);
+    expect(byId.windowId, windowInfo.windowId);
+    expect(byId.frame, windowInfo.frame);
+    expect(getWindowFrameSync(windowId: windowInfo.windowId!), isNotNull);
+
+    final unknownId = ids.reduce((a, b) => a > b ? a : b) + 1000;
+    expect(getWindowInfo(windowId: unknownId),
+        throwsA(isA<PlatformException>()));
+  }, skip: !Platform.isLinux);
+
+  testWidgets('setWindowGroupLayout tiles and cascades windows',
+      (tester) async {
+    final windowInfo = await getWindowInfo();
+    addTearDown(() => setWindowFrame(windowInfo.frame));
+    final id = windowInfo.windowId!;
+    final area = (await getScreenList())[0].visibleFrame;
+
+    // A window listed twice gets a frame for each entry.
+    final tiled = await setWindowGroupLayout(
+        [id, id], WindowGroupLayout.tile,
+        screenIndex: 0);
+    expect(tiled, hasLength(2));
+    expect(tiled[0].topLeft, area.topLeft);
+    expect(tiled[0].right, tiled[1].left);
+    expect(tiled[1].right, area.right);
+    for (final frame in tiled) {
+      expect(frame.top, area.top);
+      expect(frame.bottom, area.bottom);
+    }
+
+    final cascaded = await setWindowGroupLayout(
+        [id, id], WindowGroupLayout.cascade,
+        screenIndex: 0);
+    expect(cascaded, hasLength(2));
+    expect(cascaded[0].topLeft, area.topLeft);
+    expect(cascaded[1].topLeft - cascaded[0].topLeft, const Offset(32, 32));
+    expect(cascaded[1].size, cascaded[0].size);
+    // The virtual display has a single window, which can't be in two places.
+  }, skip: !Platform.isLinux || headless);
+
+  testWidgets('convertCoordinates uses the scale of each point\'s screen',
+      (tester) async {
+    final screen = (await getScreenList())[0];
+    final point = screen.frame.center;
+
+    final physical = await convertCoordinates([point]);
+    expect(physical.single.dx, closeTo(point.dx * screen.scaleFactor, 1e-9));
+    expect(physical.single.dy, closeTo(point.dy * screen.scaleFactor, 1e-9));
+
+    final logical = await convertCoordinates(physical, toPhysical: false);
+    expect(logical.single.dx, closeTo(point.dx, 1e-9));
+    expect(logical.single.dy, closeTo(point.dy, 1e-9));
+  }, skip: !Platform.isLinux);
+
+  testWidgets('transformPoints maps view points to the screen',
+      (tester) async {
+    final points = await transformPoints(Float64List.fromList([0, 0, 10, 20]));
+    expect(points[2] - points[0], closeTo(10, 1e-9));
+    expect(points[3] - points[1], closeTo(20, 1e-9));
+
+    final scale = getWindowScaleFactorSync()!;
+    final physical = await transformPoints(
+        Float64List.fromList([0, 0, 10, 20]),
+        toPhysical: true);
+    expect(physical[0], closeTo(points[0] * scale, 1e-9));
+    expect(physical[3] - physical[1], closeTo(20 * scale, 1e-9));
+
+    // A point far outside the window is clamped to the corner of its screen.
+    final clamped = await transformPoints(Float64List.fromList([1e6, 1e6]),
+        clampToScreen: true);
+    final corners = (await getScreenList())
+        .map((screen) => screen.visibleFrame.bottomRight);
+    expect(corners, contains(Offset(clamped[0], clamped[1])));
+  }, skip: !Platform.isLinux);
+
+  testWidgets('headless mode uses the virtual display model', (tester) async {
+    final screens = await getScreenList();
+    expect(screens, hasLength(2));
+    expect(screens[0].frame, const Rect.fromLTWH(0, 0, 1920, 1080));
+    expect(screens[0].visibleFrame, const Rect.fromLTWH(0, 32, 1920, 1048));
+    expect(screens[0].scaleFactor, 1);
+    expect(screens[1].frame, const Rect.fromLTWH(1920, 0, 1280, 720));
+    expect(screens[1].visibleFrame, screens[1].frame);
+    expect(screens[1].scaleFactor, 2);
+
+    final windowInfo = await getWindowInfo();
+    addTearDown(() => setWindowFrame(windowInfo.frame));
+    expect(windowInfo.frame, const Rect.fromLTWH(100, 100, 1280, 720));
+    expect(windowInfo.screen!.frame, screens[0].frame);
+    expect(await getWindowList(), [windowInfo.windowId]);
+
+    // Moving the window to the second screen changes its scale factor.
+    setWindowFrame(const Rect.fromLTWH(2000, 100, 640, 480));
+    final moved = await getWindowInfo();
+    expect(moved.frame, const Rect.fromLTWH(2000, 100, 640, 480));
+    expect(moved.scaleFactor, 2);
+    expect(getWindowFrameSync(), moved.frame);
+
+    final tiled = await setWindowGroupLayout(
+        [windowInfo.windowId!], WindowGroupLayout.tile,
+        screenIndex: 0);
+    expect(tiled, [screens[0].visibleFrame]);
+    expect((await getWindowInfo()).frame, screens[0].visibleFrame);
+
+    final physical = await convertCoordinates([const Offset(2000, 100)]);
+    expect(physical, [const Offset(4000, 200)]);
+  }, skip: !headless);
 }
@@ -5,6 +5,8 @@
 #include <gdk/gdkx.h>
 #endif
 
+#include <window_size/window_size_plugin.h>
+
 #include "flutter/generated_plugin_registrant.h"
 
 struct _MyApplication {
@@ -14,11 +16,10 @@ struct _MyApplication {
 
 G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 
-// Implements GApplication::activate.
-static void my_application_activate(GApplication* application) {
-  MyApplication* self = MY_APPLICATION(application);
+// Creates a window containing a Flutter view, without showing it.
+static GtkWindow* my_application_create_window(MyApplication* self) {
   GtkWindow* window =
-      GTK_WINDOW(gtk_application_window_new(GTK_APPLICATION(application)));
+      GTK_WINDOW(gtk_application_window_new(GTK_APPLICATION(self)));
 
   // Use a header bar when running in GNOME as this is the common style used
   // by applications and is the setup most users will be using (e.g. Ubuntu
@@ -48,7 +49,6 @@ static void my_application_activate(GApplication* application) {
   }
 
   gtk_window_set_default_size(window, 1280, 720);
-  gtk_widget_show(GTK_WIDGET(window));
 
   g_autoptr(FlDartProject) project = fl_dart_project_new();
   fl_dart_project_set_dart_entrypoint_arguments(project, self->dart_entrypoint_arguments);
@@ -60,6 +60,23 @@ static void my_application_activate(GApplication* application) {
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
 
   gtk_widget_grab_focus(GTK_WIDGET(view));
+
+  return window;
+}
+
+// Creates the windows kept ready by window_size for createWindow.
+static GtkWindow* create_secondary_window(gpointer user_data) {
+  return my_application_create_window(MY_APPLICATION(user_data));
+}
+
+// Implements GApplication::activate.
+static void my_application_activate(GApplication* application) {
+  MyApplication* self = MY_APPLICATION(application);
+  GtkWindow* window = my_application_create_window(self);
+  gtk_widget_show(GTK_WIDGET(window));
+
+  window_size_plugin_set_window_factory(create_secondary_window, self,
+                                        nullptr);
 }
 
 // Implements GApplication::local_command_line.
@@ -0,0 +1,34 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// The sizes of decorations on each side of a window, in screen coordinates.
+class FrameExtents {
+  /// Create new frame extents.
+  const FrameExtents(this.left, this.top, this.right, this.bottom);
+
+  /// Extents of zero on every side.
+  static const FrameExtents zero = FrameExtents(0, 0, 0, 0);
+
+  /// The size of the decorations on the left side.
+  final double left;
+
+  /// The size of the decorations on the top side.
+  final double top;
+
+  /// The size of the decorations on the right side.
+  final double right;
+
+  /// The size of the decorations on the bottom side.
+  final double bottom;
+}
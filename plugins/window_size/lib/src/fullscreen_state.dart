@@ -0,0 +1,29 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// The outcome of a request to change a window's fullscreen state.
+class FullscreenState {
+  /// Create a new fullscreen state.
+  FullscreenState(this.fullscreen, this.bypassingCompositor);
+
+  /// Whether the window manager made the window fullscreen.
+  final bool fullscreen;
+
+  /// Whether the window asked the compositor to unredirect it, and the window
+  /// manager supports that request.
+  ///
+  /// The compositor may still decline, e.g. if other windows overlap the
+  /// fullscreen window.
+  final bool bypassingCompositor;
+}
@@ -0,0 +1,28 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+import 'dart:ui';
+
+/// The position of the pointer on the desktop, regardless of which window it
+/// is over.
+class GlobalPointerPosition {
+  /// Create a new pointer position.
+  GlobalPointerPosition(this.position, this.screenIndex);
+
+  /// The position of the pointer, in screen coordinates.
+  final Offset position;
+
+  /// The index, in the list returned by getScreenList, of the screen
+  /// containing the pointer, or -1 if it is not on any screen.
+  final int screenIndex;
+}
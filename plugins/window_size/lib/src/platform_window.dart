@@ -13,13 +13,18 @@
 // limitations under the License.
 import 'dart:ui';
 
+import 'frame_extents.dart';
 import 'screen.dart';
 
 /// Represents a window, containing information about its size, position, and
 /// properties.
 class PlatformWindow {
   /// Create a new window.
-  PlatformWindow(this.frame, this.scaleFactor, this.screen);
+  PlatformWindow(this.frame, this.scaleFactor, this.screen,
+      {this.textScaleFactor,
+      this.windowId,
+      this.frameExtents,
+      this.shadowExtents});
 
   /// The frame of the screen, in screen coordinates.
   final Rect frame;
@@ -27,6 +32,23 @@ class PlatformWindow {
   /// The number of pixels per screen coordinate for this screen.
   final double scaleFactor;
 
+  /// The additional factor by which text is scaled in this window, if known.
+  ///
+  /// See [Screen.textScaleFactor].
+  final double? textScaleFactor;
+
   /// The (or a) screen containing this window, if any.
   final Screen? screen;
+
+  /// The id that can be used to target this window in other calls, if the
+  /// platform supports addressing multiple windows.
+  final int? windowId;
+
+  /// The size of the window manager's decorations around [frame], if known.
+  final FrameExtents? frameExtents;
+
+  /// The size of the shadow drawn around the window by client-side
+  /// decorations, which is included in the window's surface but not in
+  /// [frame], if known.
+  final FrameExtents? shadowExtents;
 }
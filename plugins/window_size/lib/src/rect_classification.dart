@@ -0,0 +1,28 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// Describes how a rect overlaps the available screens.
+class RectClassification {
+  /// Create a new classification.
+  RectClassification(this.screenIndex, this.overlaps);
+
+  /// The index, in the list returned by getScreenList, of the screen that
+  /// contains the largest portion of the rect, or -1 if the rect is not on
+  /// any screen.
+  final int screenIndex;
+
+  /// The fraction of the rect's area that lies on each screen, indexed the
+  /// same way as the list returned by getScreenList.
+  final List<double> overlaps;
+}
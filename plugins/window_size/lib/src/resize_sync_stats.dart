@@ -0,0 +1,41 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// Measurements of how long programmatic resizes take to be applied by the
+/// window manager and painted (configure+paint).
+///
+/// A paint of the window doesn't mean the Flutter view has drawn a frame at
+/// the new size yet, since the engine rasterizes on its own thread.
+class ResizeSyncStats {
+  /// Create a new set of statistics.
+  ResizeSyncStats(this.count, this.timeouts, this.lastLatency,
+      this.averageLatency, this.maxLatency);
+
+  /// The number of resizes that were configured and painted at their new size.
+  final int count;
+
+  /// The number of resizes that were not configured and painted in time, or
+  /// were superseded by a later resize.
+  final int timeouts;
+
+  /// The time between requesting the most recent resize and its first
+  /// paint.
+  final Duration lastLatency;
+
+  /// The average time between requesting a resize and its first paint.
+  final Duration averageLatency;
+
+  /// The longest time between requesting a resize and its first paint.
+  final Duration maxLatency;
+}
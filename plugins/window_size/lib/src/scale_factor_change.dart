@@ -0,0 +1,34 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// A change to the scale factor of the window containing this Flutter
+/// instance, e.g. because it moved to another screen.
+class ScaleFactorChange {
+  /// Create a new scale factor change.
+  ScaleFactorChange(this.windowId, this.oldScaleFactor, this.scaleFactor,
+      this.screenIndex);
+
+  /// The id of the window, as used by the functions that take a `windowId`.
+  final int windowId;
+
+  /// The scale factor before the change.
+  final double oldScaleFactor;
+
+  /// The new scale factor.
+  final double scaleFactor;
+
+  /// The index, in the list returned by getScreenList, of the screen showing
+  /// the window.
+  final int screenIndex;
+}
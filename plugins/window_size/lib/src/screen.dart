@@ -17,7 +17,8 @@ import 'dart:ui';
 /// properties.
 class Screen {
   /// Create a new screen.
-  Screen(this.frame, this.visibleFrame, this.scaleFactor);
+  Screen(this.frame, this.visibleFrame, this.scaleFactor,
+      {this.textScaleFactor});
 
   /// The frame of the screen, in screen coordinates.
   final Rect frame;
@@ -28,4 +29,11 @@ class Screen {
 
   /// The number of pixels per screen coordinate for this screen.
   final double scaleFactor;
+
+  /// The additional factor by which text is scaled on this screen, if known.
+  ///
+  /// On Linux, fractional scales such as 1.25 or 1.5 are set up by scaling the
+  /// font resolution on top of the integer [scaleFactor]. This doesn't change
+  /// the size of screen coordinates, so isn't included in [scaleFactor].
+  final double? textScaleFactor;
 }
@@ -0,0 +1,40 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+import 'dart:ui';
+
+import 'screen.dart';
+
+/// A consistent view of the geometry of the window containing this Flutter
+/// instance.
+class WindowGeometry {
+  /// Create a new window geometry.
+  WindowGeometry(this.windowId, this.frame, this.scaleFactor, this.screenIndex,
+      this.screen);
+
+  /// The id of the window, as used by the functions that take a `windowId`.
+  final int windowId;
+
+  /// The frame of the window, in screen coordinates.
+  final Rect frame;
+
+  /// The number of pixels per screen coordinate for the window.
+  final double scaleFactor;
+
+  /// The index of [screen] in the list returned by getScreenList, or null if
+  /// it is unknown.
+  final int? screenIndex;
+
+  /// The screen showing the window, or null if it is unknown.
+  final Screen? screen;
+}
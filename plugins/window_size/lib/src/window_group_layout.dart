@@ -0,0 +1,27 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// Ways to arrange a group of windows on a screen.
+enum WindowGroupLayout {
+  /// Divides the screen's visible frame into a grid, one cell per window.
+  tile,
+
+  /// Overlaps the windows diagonally from the top left of the screen,
+  /// keeping their sizes where possible.
+  cascade,
+
+  /// Makes each window fill the visible frame of its screen, with later
+  /// windows on top.
+  stack,
+}
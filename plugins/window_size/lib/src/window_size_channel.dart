@@ -12,12 +12,21 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 import 'dart:async';
+import 'dart:io';
+import 'dart:typed_data';
 import 'dart:ui';
 
 import 'package:flutter/services.dart';
 
+import 'frame_extents.dart';
+import 'fullscreen_state.dart';
+import 'global_pointer_position.dart';
 import 'platform_window.dart';
+import 'rect_classification.dart';
+import 'resize_sync_stats.dart';
+import 'scale_factor_change.dart';
 import 'screen.dart';
+import 'window_group_layout.dart';
 
 /// The name of the plugin's platform channel.
 const String _windowSizeChannelName = 'flutter/windowsize';
@@ -36,8 +45,22 @@ const String _getWindowInfoMethod = 'getWindowInfo';
 /// The method name to set the frame of a window.
 ///
 /// Takes a frame array, as documented for the value of _frameKey.
+///
+/// On Linux, if the size changes, the response is sent once the window manager
+/// has applied the new size and GTK has painted the window (configure+paint).
+/// This doesn't guarantee that the Flutter view has drawn a frame at the new
+/// size yet, since the engine rasterizes on its own thread.
 const String _setWindowFrameMethod = 'setWindowFrame';
 
+/// The method name to request statistics on how long resizes take to be
+/// configured and painted.
+///
+/// Returns a map with _countKey, _timeoutsKey, _lastLatencyKey,
+/// _averageLatencyKey and _maxLatencyKey.
+///
+/// Only implemented for Linux.
+const String _getResizeSyncStatsMethod = 'getResizeSyncStats';
+
 /// The method name to set the minimum size of a window.
 ///
 /// Takes a window size array, with the value is a list of two doubles:
@@ -66,6 +89,13 @@ const String _setWindowTitleMethod = 'setWindowTitle';
 const String _setWindowTitleRepresentedUrlMethod =
     'setWindowTitleRepresentedUrl';
 
+/// The method name to set the window icon.
+///
+/// Takes a map with _dataKey, _widthKey and _heightKey.
+///
+/// Only implemented for Linux.
+const String _setWindowIconMethod = 'setWindowIcon';
+
 /// The method name to get the minimum size of a window.
 ///
 /// Returns a window size array, with the value is a list of two doubles:
@@ -90,6 +120,249 @@ const String _getWindowMaximumSizeMethod = 'getWindowMaximumSize';
 /// be visible.
 const String _setWindowVisibilityMethod = 'setWindowVisibility';
 
+/// The method name to park or reveal a window.
+///
+/// The argument will be a boolean; true to park the window. A parked window is
+/// invisible and ignores input, but stays mapped and ready to render, so that
+/// revealing it again is close to instant.
+///
+/// Only implemented for Linux.
+const String _setWindowParkedMethod = 'setWindowParked';
+
+/// The method name to query whether a window is parked.
+///
+/// Returns a boolean.
+///
+/// Only implemented for Linux.
+const String _isWindowParkedMethod = 'isWindowParked';
+
+/// The method name to enable or disable edge snapping while a window is
+/// moved.
+///
+/// Takes a map with _enabledKey and optionally _thresholdKey.
+///
+/// Only implemented for Linux.
+const String _setWindowSnappingMethod = 'setWindowSnapping';
+
+/// The method name to make a window fullscreen, or restore it.
+///
+/// Takes a map with _fullscreenKey, and optionally _screenIndexKey and
+/// _bypassCompositorKey. Responds once the window manager has applied the
+/// change, with a map with _fullscreenKey and _bypassCompositorKey.
+///
+/// Only implemented for Linux.
+const String _setWindowFullscreenMethod = 'setWindowFullscreen';
+
+/// The method name to enable or disable lifecycle signals for the window
+/// containing this Flutter instance.
+///
+/// While enabled, the engine is told the app is paused when the window is
+/// hidden, iconified or withdrawn, and resumed when it is shown again. After
+/// the window has been in the background for the memory pressure delay, a
+/// memoryPressure system message is sent.
+///
+/// Takes a map with _enabledKey and optionally _memoryPressureDelayKey.
+///
+/// Only implemented for Linux.
+const String _setLifecycleSignalsMethod = 'setLifecycleSignals';
+
+/// The method name to configure the pool of windows kept ready for
+/// _createWindowMethod.
+///
+/// Takes a map with _sizeKey and optionally _idleTimeoutKey.
+///
+/// Only implemented for Linux, where the runner must provide a window factory.
+const String _configureWindowPoolMethod = 'configureWindowPool';
+
+/// The method name to create a secondary window, taking one from the pool if
+/// available.
+///
+/// Takes a map with optional _frameKey and _visibleKey. Returns the new
+/// window's id.
+///
+/// Only implemented for Linux, where the runner must provide a window factory.
+const String _createWindowMethod = 'createWindow';
+
+/// The method name to classify rects by the screens they overlap.
+///
+/// Takes a Float64List of packed [left, top, width, height] rects, and returns
+/// a map with _screensKey and _overlapsKey.
+///
+/// Only implemented for Linux.
+const String _classifyRectsMethod = 'classifyRects';
+
+/// The method name to request the ids of the application's windows.
+///
+/// Returns a list of window ids, which can be passed as _windowIdKey.
+///
+/// Only implemented for Linux.
+const String _getWindowListMethod = 'getWindowList';
+
+/// The method name to arrange a group of windows.
+///
+/// Takes a map with _windowIdsKey, _layoutKey and optionally
+/// _screenIndexKey. Returns the list of frames applied, in the same order as
+/// the window ids.
+///
+/// Only implemented for Linux.
+const String _setWindowGroupLayoutMethod = 'setWindowGroupLayout';
+
+/// The method name to add a global pointer tracking subscription.
+///
+/// While there is at least one subscription, _pointerPositionChangedMethod is
+/// called on each frame in which the pointer has moved.
+///
+/// Only implemented for Linux.
+const String _startPointerTrackingMethod = 'startPointerTracking';
+
+/// The method name to remove a global pointer tracking subscription.
+///
+/// Only implemented for Linux.
+const String _stopPointerTrackingMethod = 'stopPointerTracking';
+
+/// The method name to convert points between logical and physical pixels.
+///
+/// Takes a map with _pointsKey and _toPhysicalKey. Returns a Float64List of
+/// the converted points, packed in the same way.
+///
+/// Only implemented for Linux.
+const String _convertCoordinatesMethod = 'convertCoordinates';
+
+/// The method name to map points from a window's view to screen coordinates.
+///
+/// Takes a map with _pointsKey, and optionally _clampToScreenKey and
+/// _toPhysicalKey. Returns a Float64List of the mapped points, packed in the
+/// same way.
+///
+/// Only implemented for Linux.
+const String _transformPointsMethod = 'transformPoints';
+
+/// The method name for the Dart-side callback called with the global pointer
+/// position.
+///
+/// The argument is a Float64List of [x, y, screenIndex], where screenIndex is
+/// -1 if the pointer is not on any screen.
+const String _pointerPositionChangedMethod = 'pointerPositionChanged';
+
+/// The method name for the Dart-side callback called when the scale factor of
+/// the window containing this Flutter instance changes.
+///
+/// The argument is a map with _windowIdKey, _oldScaleFactorKey,
+/// _scaleFactorKey and _screenIndexKey.
+const String _scaleFactorChangedMethod = 'scaleFactorChanged';
+
+/// The scale factor before a change, as a double.
+const String _oldScaleFactorKey = 'oldScaleFactor';
+
+// Keys for method calls that target a specific window.
+//
+// If the arguments of a window method are a map containing _windowIdKey, the
+// call applies to that window, and the method's arguments are the value of
+// _argumentsKey. Otherwise the call applies to the window containing this
+// Flutter instance. Only the Linux plugin understands this form.
+
+/// The id of the window a method call applies to, as an int. Also used in
+/// window info maps.
+const String _windowIdKey = 'windowId';
+
+/// The arguments of a method call that targets a specific window.
+const String _argumentsKey = 'arguments';
+
+// Keys for _setWindowGroupLayoutMethod arguments.
+
+/// The ids of the windows to arrange, as a list of ints.
+const String _windowIdsKey = 'windowIds';
+
+/// The layout to apply, as the name of a WindowGroupLayout value.
+const String _layoutKey = 'layout';
+
+/// The index of the screen to arrange the windows on, as an int. If absent,
+/// the screen of the first window is used, except for stacking, where each
+/// window stays on its own screen.
+const String _screenIndexKey = 'screenIndex';
+
+// Keys for _convertCoordinatesMethod arguments.
+
+/// The points to convert, as a Float64List of packed [x, y] screen
+/// coordinates.
+const String _pointsKey = 'points';
+
+/// Whether to convert from logical to physical pixels, rather than the
+/// reverse, as a bool.
+const String _toPhysicalKey = 'toPhysical';
+
+// Keys for _transformPointsMethod arguments, which also uses _pointsKey for
+// points in the view's logical coordinates, and _toPhysicalKey.
+
+/// Whether to clamp the mapped points to the visible frame of the window's
+/// screen, as a bool.
+const String _clampToScreenKey = 'clampToScreen';
+
+// Keys for _setWindowSnappingMethod arguments.
+
+/// Whether snapping is enabled, as a bool.
+const String _enabledKey = 'enabled';
+
+/// The distance within which the window snaps to an edge, in screen
+/// coordinates as a double.
+const String _thresholdKey = 'threshold';
+
+// Keys for _setWindowFullscreenMethod arguments and its response. The screen
+// is given as _screenIndexKey; if absent, the window's current screen is
+// used.
+
+/// Whether the window is fullscreen, as a bool.
+const String _fullscreenKey = 'fullscreen';
+
+/// Whether the compositor is asked to unredirect the fullscreen window, as a
+/// bool.
+const String _bypassCompositorKey = 'bypassCompositor';
+
+// Keys for _setLifecycleSignalsMethod arguments, which also uses _enabledKey.
+
+/// How long the window must be in the background before memoryPressure is
+/// sent, in milliseconds as an int. Negative to never send it.
+const String _memoryPressureDelayKey = 'memoryPressureDelay';
+
+// Keys for _configureWindowPoolMethod arguments.
+
+/// The number of windows to keep ready, as an int.
+const String _sizeKey = 'size';
+
+/// How long the pool may go without a window being created before it is
+/// emptied, in milliseconds as an int. Zero or absent to never empty it.
+const String _idleTimeoutKey = 'idleTimeout';
+
+// Keys for _createWindowMethod arguments. The window's initial frame is given
+// as _frameKey.
+
+/// Whether to show the new window, as a bool. Defaults to true.
+const String _visibleKey = 'visible';
+
+// Keys for _setWindowIconMethod arguments.
+
+/// The icon's pixels, as a Uint8List of unpremultiplied RGBA values in rows
+/// from top to bottom.
+const String _dataKey = 'data';
+
+/// The icon's dimensions in pixels, as ints.
+const String _widthKey = 'width';
+const String _heightKey = 'height';
+
+// Keys for the map returned by _getResizeSyncStatsMethod.
+
+/// The number of resizes configured and painted at their new size, as an int.
+const String _countKey = 'count';
+
+/// The number of resizes not configured and painted in time, as an int.
+const String _timeoutsKey = 'timeouts';
+
+/// Latencies between a resize request and the first paint after the window
+/// manager applied it, in milliseconds as doubles.
+const String _lastLatencyKey = 'lastLatency';
+const String _averageLatencyKey = 'averageLatency';
+const String _maxLatencyKey = 'maxLatency';
+
 // Keys for screen and window maps returned by _getScreenListMethod.
 
 /// The frame of a screen or window. The value is a list of four doubles:
@@ -108,6 +381,28 @@ const String _visibleFrameKey = 'visibleFrame';
 /// between sizes as seen by Flutter and sizes in native screen coordinates.
 const String _scaleFactorKey = 'scaleFactor';
 
+/// The text scale factor for a screen or window, as a double.
+///
+/// This is the factor by which text is scaled in addition to the scale
+/// factor, e.g. from the font resolution on Linux. It doesn't affect screen
+/// coordinates.
+///
+/// Only implemented for Linux.
+const String _textScaleFactorKey = 'textScaleFactor';
+
+/// The size of the window manager's decorations around a window's frame. The
+/// value is a list of four doubles:
+///   [left, top, right, bottom]
+///
+/// Only used for windows, and only on Linux.
+const String _frameExtentsKey = 'frameExtents';
+
+/// The size of the shadow drawn around a window by client-side decorations.
+/// The value format is the same as _frameExtentsKey's.
+///
+/// Only used for windows, and only on Linux.
+const String _shadowExtentsKey = 'shadowExtents';
+
 /// The screen containing this window, if any. The value is a screen map, or
 /// null if the window is not visible on a screen.
 ///
@@ -117,14 +412,39 @@ const String _scaleFactorKey = 'scaleFactor';
 /// screen to report.
 const String _screenKey = 'screen';
 
+/// For each rect passed to _classifyRectsMethod, the index of the screen
+/// containing the largest portion of the rect, or -1 if none. The value is an
+/// Int32List.
+const String _screensKey = 'screens';
+
+/// For each rect passed to _classifyRectsMethod, the fraction of its area on
+/// each screen. The value is a Float64List with one row per rect and one
+/// column per screen.
+const String _overlapsKey = 'overlaps';
+
 /// A singleton object that handles the interaction with the platform channel.
 class WindowSizeChannel {
   /// Private constructor.
-  WindowSizeChannel._();
+  WindowSizeChannel._() {
+    _platformChannel.setMethodCallHandler(_callbackHandler);
+  }
 
   final MethodChannel _platformChannel =
       const MethodChannel(_windowSizeChannelName);
 
+  /// Controller for [globalPointerPositions]; tracking runs while it has
+  /// listeners.
+  late final StreamController<GlobalPointerPosition> _pointerPositions =
+      StreamController<GlobalPointerPosition>.broadcast(
+          onListen: () =>
+              _platformChannel.invokeMethod(_startPointerTrackingMethod),
+          onCancel: () =>
+              _platformChannel.invokeMethod(_stopPointerTrackingMethod));
+
+  /// Controller for [scaleFactorChanges].
+  final StreamController<ScaleFactorChange> _scaleFactorChanges =
+      StreamController<ScaleFactorChange>.broadcast();
+
   /// The static instance of the menu channel.
   static final WindowSizeChannel instance = new WindowSizeChannel._();
 
@@ -139,14 +459,64 @@ class WindowSizeChannel {
     return screenList;
   }
 
-  /// Returns information about the window containing this Flutter instance.
-  Future<PlatformWindow> getWindowInfo() async {
-    final response = await _platformChannel.invokeMethod(_getWindowInfoMethod);
+  /// Returns information about the window containing this Flutter instance,
+  /// or the window with [windowId] if provided.
+  Future<PlatformWindow> getWindowInfo({int? windowId}) async {
+    final response =
+        await _invokeWindowMethod(_getWindowInfoMethod, null, windowId);
 
     final screenInfo = response[_screenKey];
     final screen = screenInfo == null ? null : _screenFromInfoMap(screenInfo);
     return PlatformWindow(_rectFromLTWHList(response[_frameKey].cast<double>()),
-        response[_scaleFactorKey], screen);
+        response[_scaleFactorKey], screen,
+        textScaleFactor: response[_textScaleFactorKey],
+        windowId: response[_windowIdKey],
+        frameExtents: _frameExtentsFromList(response[_frameExtentsKey]),
+        shadowExtents: _frameExtentsFromList(response[_shadowExtentsKey]));
+  }
+
+  /// Returns the ids of the application's windows.
+  Future<List<int>> getWindowList() async {
+    final response = await _platformChannel.invokeMethod(_getWindowListMethod);
+    return List<int>.from(response.cast<int>());
+  }
+
+  /// Arranges the windows with [windowIds] according to [layout], returning
+  /// the frame applied to each.
+  Future<List<Rect>> setWindowGroupLayout(
+      List<int> windowIds, WindowGroupLayout layout,
+      {int? screenIndex}) async {
+    final arguments = <String, dynamic>{
+      _windowIdsKey: windowIds,
+      _layoutKey: layout.toString().split('.').last,
+    };
+    if (screenIndex != null) {
+      arguments[_screenIndexKey] = screenIndex;
+    }
+    final response = await _platformChannel.invokeMethod(
+        _setWindowGroupLayoutMethod, arguments);
+    return List<Rect>.from(response
+        .map((frame) => _rectFromLTWHList(frame.cast<double>()))
+        .toList());
+  }
+
+  /// Invokes [method] for the window with [windowId], or for the window
+  /// containing this Flutter instance if [windowId] is null.
+  ///
+  /// Throws an [UnsupportedError] if [windowId] is given on a platform other
+  /// than Linux, rather than applying the call to the wrong window.
+  Future<dynamic> _invokeWindowMethod(String method,
+      [dynamic arguments, int? windowId]) {
+    if (windowId == null) {
+      return _platformChannel.invokeMethod(method, arguments);
+    }
+    if (!Platform.isLinux) {
+      throw UnsupportedError('windowId is only supported on Linux');
+    }
+    return _platformChannel.invokeMethod(method, <String, dynamic>{
+      _windowIdKey: windowId,
+      _argumentsKey: arguments,
+    });
   }
 
   /// Sets the frame of the window containing this Flutter instance, in
@@ -155,22 +525,101 @@ class WindowSizeChannel {
   /// The platform may adjust the frame as necessary if the provided frame would
   /// cause significant usability issues (e.g., a window with no visible portion
   /// that can be used to move the window).
-  void setWindowFrame(Rect frame) async {
+  void setWindowFrame(Rect frame, {int? windowId}) async {
     assert(!frame.isEmpty, 'Cannot set window frame to an empty rect.');
     assert(frame.isFinite, 'Cannot set window frame to a non-finite rect.');
-    await _platformChannel.invokeMethod(_setWindowFrameMethod,
-        [frame.left, frame.top, frame.width, frame.height]);
+    await _invokeWindowMethod(_setWindowFrameMethod,
+        [frame.left, frame.top, frame.width, frame.height], windowId);
+  }
+
+  /// Returns statistics on how long resizes of the window take to be
+  /// configured and painted.
+  Future<ResizeSyncStats> getResizeSyncStats({int? windowId}) async {
+    final response =
+        await _invokeWindowMethod(_getResizeSyncStatsMethod, null, windowId);
+    return ResizeSyncStats(
+        response[_countKey],
+        response[_timeoutsKey],
+        _durationFromMilliseconds(response[_lastLatencyKey]),
+        _durationFromMilliseconds(response[_averageLatencyKey]),
+        _durationFromMilliseconds(response[_maxLatencyKey]));
   }
 
   /// Sets the minimum size of the window containing this Flutter instance.
-  void setWindowMinSize(Size size) async {
-    await _platformChannel
-        .invokeMethod(_setWindowMinimumSizeMethod, [size.width, size.height]);
+  void setWindowMinSize(Size size, {int? windowId}) async {
+    await _invokeWindowMethod(
+        _setWindowMinimumSizeMethod, [size.width, size.height], windowId);
   }
 
   /// Sets the visibility of the window.
-  void setWindowVisibility({required bool visible}) async {
-    await _platformChannel.invokeMethod(_setWindowVisibilityMethod, visible);
+  void setWindowVisibility({required bool visible, int? windowId}) async {
+    await _invokeWindowMethod(_setWindowVisibilityMethod, visible, windowId);
+  }
+
+  /// Parks the window if [parked] is true, or reveals it otherwise.
+  void setWindowParked(bool parked, {int? windowId}) async {
+    await _invokeWindowMethod(_setWindowParkedMethod, parked, windowId);
+  }
+
+  /// Returns whether the window is parked.
+  Future<bool> isWindowParked({int? windowId}) async {
+    return await _invokeWindowMethod(_isWindowParkedMethod, null, windowId);
+  }
+
+  /// Enables or disables edge snapping while the window is moved.
+  void setWindowSnapping(bool enabled,
+      {double? threshold, int? windowId}) async {
+    await _invokeWindowMethod(
+        _setWindowSnappingMethod,
+        {
+          _enabledKey: enabled,
+          if (threshold != null) _thresholdKey: threshold,
+        },
+        windowId);
+  }
+
+  /// Makes the window fullscreen on the screen at [screenIndex], or restores
+  /// it.
+  Future<FullscreenState> setWindowFullscreen(bool fullscreen,
+      {int? screenIndex, bool bypassCompositor = false, int? windowId}) async {
+    final response = await _invokeWindowMethod(
+        _setWindowFullscreenMethod,
+        {
+          _fullscreenKey: fullscreen,
+          if (screenIndex != null) _screenIndexKey: screenIndex,
+          _bypassCompositorKey: bypassCompositor,
+        },
+        windowId);
+    return FullscreenState(
+        response[_fullscreenKey], response[_bypassCompositorKey]);
+  }
+
+  /// Enables or disables lifecycle signals for the window containing this
+  /// Flutter instance.
+  void setLifecycleSignals(bool enabled,
+      {Duration? memoryPressureDelay}) async {
+    await _platformChannel.invokeMethod(_setLifecycleSignalsMethod, {
+      _enabledKey: enabled,
+      if (memoryPressureDelay != null)
+        _memoryPressureDelayKey: memoryPressureDelay.inMilliseconds,
+    });
+  }
+
+  /// Sets the number of secondary windows kept ready for [createWindow].
+  void configureWindowPool(int size, {Duration? idleTimeout}) async {
+    await _platformChannel.invokeMethod(_configureWindowPoolMethod, {
+      _sizeKey: size,
+      if (idleTimeout != null) _idleTimeoutKey: idleTimeout.inMilliseconds,
+    });
+  }
+
+  /// Creates a secondary window, returning its id.
+  Future<int> createWindow({Rect? frame, bool visible = true}) async {
+    return await _platformChannel.invokeMethod(_createWindowMethod, {
+      if (frame != null)
+        _frameKey: [frame.left, frame.top, frame.width, frame.height],
+      _visibleKey: visible,
+    });
   }
 
   // Window maximum size unconstrained is passed over the channel as -1.
@@ -179,16 +628,34 @@ class WindowSizeChannel {
   }
 
   /// Sets the maximum size of the window containing this Flutter instance.
-  void setWindowMaxSize(Size size) async {
-    await _platformChannel.invokeMethod(_setWindowMaximumSizeMethod, [
-      _channelRepresentationForMaxDimension(size.width),
-      _channelRepresentationForMaxDimension(size.height),
-    ]);
+  void setWindowMaxSize(Size size, {int? windowId}) async {
+    await _invokeWindowMethod(
+        _setWindowMaximumSizeMethod,
+        [
+          _channelRepresentationForMaxDimension(size.width),
+          _channelRepresentationForMaxDimension(size.height),
+        ],
+        windowId);
   }
 
   /// Sets the title of the window containing this Flutter instance.
-  void setWindowTitle(String title) async {
-    await _platformChannel.invokeMapMethod(_setWindowTitleMethod, title);
+  void setWindowTitle(String title, {int? windowId}) async {
+    await _invokeWindowMethod(_setWindowTitleMethod, title, windowId);
+  }
+
+  /// Sets the icon of the window containing this Flutter instance.
+  void setWindowIcon(Uint8List rgba, int width, int height,
+      {int? windowId}) async {
+    assert(rgba.length >= width * height * 4,
+        'Icon data is too short for its dimensions.');
+    await _invokeWindowMethod(
+        _setWindowIconMethod,
+        <String, dynamic>{
+          _dataKey: rgba,
+          _widthKey: width,
+          _heightKey: height,
+        },
+        windowId);
   }
 
   /// Sets the title's represented URL of the window containing this Flutter instance.
@@ -198,9 +665,9 @@ class WindowSizeChannel {
   }
 
   /// Gets the minimum size of the window containing this Flutter instance.
-  Future<Size> getWindowMinSize() async {
+  Future<Size> getWindowMinSize({int? windowId}) async {
     final response =
-        await _platformChannel.invokeMethod(_getWindowMinimumSizeMethod);
+        await _invokeWindowMethod(_getWindowMinimumSizeMethod, null, windowId);
     return _sizeFromWHList(List<double>.from(response.cast<double>()));
   }
 
@@ -210,9 +677,9 @@ class WindowSizeChannel {
   }
 
   /// Gets the maximum size of the window containing this Flutter instance.
-  Future<Size> getWindowMaxSize() async {
+  Future<Size> getWindowMaxSize({int? windowId}) async {
     final response =
-        await _platformChannel.invokeMethod(_getWindowMaximumSizeMethod);
+        await _invokeWindowMethod(_getWindowMaximumSizeMethod, null, windowId);
     return _sizeFromWHList(
       List<double>.from(
         response.cast<double>().map(_maxDimensionFromChannelRepresentation),
@@ -220,6 +687,59 @@ class WindowSizeChannel {
     );
   }
 
+  /// Returns, for each of [rects], the screens it overlaps.
+  Future<List<RectClassification>> classifyRects(List<Rect> rects) async {
+    final packedRects = Float64List(rects.length * 4);
+    for (var i = 0; i < rects.length; i++) {
+      packedRects[i * 4] = rects[i].left;
+      packedRects[i * 4 + 1] = rects[i].top;
+      packedRects[i * 4 + 2] = rects[i].width;
+      packedRects[i * 4 + 3] = rects[i].height;
+    }
+    final response =
+        await _platformChannel.invokeMethod(_classifyRectsMethod, packedRects);
+
+    final Int32List screens = response[_screensKey];
+    final Float64List overlaps = response[_overlapsKey];
+    final screenCount = rects.isEmpty ? 0 : overlaps.length ~/ rects.length;
+    return List<RectClassification>.generate(
+        rects.length,
+        (i) => RectClassification(
+            screens[i],
+            Float64List.sublistView(
+                overlaps, i * screenCount, (i + 1) * screenCount)));
+  }
+
+  /// Converts [points] between logical and physical pixels.
+  Future<List<Offset>> convertCoordinates(List<Offset> points,
+      {required bool toPhysical}) async {
+    final packedPoints = Float64List(points.length * 2);
+    for (var i = 0; i < points.length; i++) {
+      packedPoints[i * 2] = points[i].dx;
+      packedPoints[i * 2 + 1] = points[i].dy;
+    }
+    final Float64List response = await _platformChannel.invokeMethod(
+        _convertCoordinatesMethod,
+        {_pointsKey: packedPoints, _toPhysicalKey: toPhysical});
+    return List<Offset>.generate(
+        points.length, (i) => Offset(response[i * 2], response[i * 2 + 1]));
+  }
+
+  /// Maps [points] from the window's view to screen coordinates.
+  Future<Float64List> transformPoints(Float64List points,
+      {bool clampToScreen = false,
+      bool toPhysical = false,
+      int? windowId}) async {
+    return await _invokeWindowMethod(
+        _transformPointsMethod,
+        {
+          _pointsKey: points,
+          _clampToScreenKey: clampToScreen,
+          _toPhysicalKey: toPhysical,
+        },
+        windowId);
+  }
+
   /// Given an array of the form [left, top, width, height], return the
   /// corresponding [Rect].
   ///
@@ -228,6 +748,46 @@ class WindowSizeChannel {
     return Rect.fromLTWH(ltwh[0], ltwh[1], ltwh[2], ltwh[3]);
   }
 
+  /// A stream of global pointer positions, updated at most once per frame
+  /// while it has listeners.
+  Stream<GlobalPointerPosition> get globalPointerPositions =>
+      _pointerPositions.stream;
+
+  /// A stream of changes to the scale factor of the window containing this
+  /// Flutter instance.
+  Stream<ScaleFactorChange> get scaleFactorChanges =>
+      _scaleFactorChanges.stream;
+
+  /// Handles calls from the native plugin.
+  Future<void> _callbackHandler(MethodCall methodCall) async {
+    if (methodCall.method == _pointerPositionChangedMethod) {
+      final Float64List position = methodCall.arguments;
+      _pointerPositions.add(GlobalPointerPosition(
+          Offset(position[0], position[1]), position[2].toInt()));
+    } else if (methodCall.method == _scaleFactorChangedMethod) {
+      final Map<dynamic, dynamic> change = methodCall.arguments;
+      _scaleFactorChanges.add(ScaleFactorChange(
+          change[_windowIdKey],
+          change[_oldScaleFactorKey],
+          change[_scaleFactorKey],
+          change[_screenIndexKey]));
+    }
+  }
+
+  /// Given an array of the form [left, top, right, bottom], or null, return
+  /// the corresponding [FrameExtents].
+  FrameExtents? _frameExtentsFromList(List<dynamic>? ltrb) {
+    if (ltrb == null) {
+      return null;
+    }
+    return FrameExtents(ltrb[0], ltrb[1], ltrb[2], ltrb[3]);
+  }
+
+  /// Returns the [Duration] corresponding to [milliseconds].
+  Duration _durationFromMilliseconds(double milliseconds) {
+    return Duration(microseconds: (milliseconds * 1000).round());
+  }
+
   /// Given an array of the form [width, height], return the corresponding
   /// [Size].
   ///
@@ -244,6 +804,7 @@ class WindowSizeChannel {
     return Screen(
         _rectFromLTWHList(map[_frameKey].cast<double>()),
         _rectFromLTWHList(map[_visibleFrameKey].cast<double>()),
-        map[_scaleFactorKey]);
+        map[_scaleFactorKey],
+        textScaleFactor: map[_textScaleFactorKey]);
   }
 }
@@ -0,0 +1,186 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:ui';
+
+import 'package:ffi/ffi.dart';
+
+import 'screen.dart';
+import 'window_geometry.dart';
+
+// Mirrors WindowSizeRect in window_size_ffi.h.
+class _WindowSizeRect extends Struct {
+  @Double()
+  external double x;
+
+  @Double()
+  external double y;
+
+  @Double()
+  external double width;
+
+  @Double()
+  external double height;
+
+  Rect toRect() => Rect.fromLTWH(x, y, width, height);
+}
+
+// Mirrors WindowSizeMonitor in window_size_ffi.h.
+class _WindowSizeMonitor extends Struct {
+  external _WindowSizeRect frame;
+
+  external _WindowSizeRect visibleFrame;
+
+  @Double()
+  external double scaleFactor;
+}
+
+// Mirrors WindowSizeGeometryMailbox in window_size_ffi.h.
+class _WindowSizeGeometryMailbox extends Struct {
+  @Uint32()
+  external int sequence;
+
+  @Int32()
+  external int monitorIndex;
+
+  @Int64()
+  external int windowId;
+
+  external _WindowSizeRect frame;
+
+  @Double()
+  external double scaleFactor;
+
+  external _WindowSizeMonitor monitor;
+}
+
+typedef _GetWindowFrameNative = _WindowSizeRect Function(Int64 windowId);
+typedef _GetWindowFrame = _WindowSizeRect Function(int windowId);
+typedef _GetWindowScaleFactorNative = Double Function(Int64 windowId);
+typedef _GetWindowScaleFactor = double Function(int windowId);
+typedef _GetMonitorsNative = Int32 Function(
+    Pointer<_WindowSizeMonitor> monitors, Int32 capacity);
+typedef _GetMonitors = int Function(
+    Pointer<_WindowSizeMonitor> monitors, int capacity);
+typedef _ReadGeometryMailboxNative = Void Function(
+    Pointer<_WindowSizeGeometryMailbox> geometry);
+typedef _ReadGeometryMailbox = void Function(
+    Pointer<_WindowSizeGeometryMailbox> geometry);
+
+/// Synchronous bindings for the C ABI in window_size_ffi.h.
+///
+/// These read a snapshot of the geometry that the plugin keeps up to date, so
+/// they return immediately instead of round-tripping through the platform
+/// channel.
+class WindowSizeFfi {
+  WindowSizeFfi._(DynamicLibrary library)
+      : _getWindowFrame = library
+            .lookupFunction<_GetWindowFrameNative, _GetWindowFrame>(
+                'window_size_get_window_frame'),
+        _getWindowScaleFactor = library.lookupFunction<
+                _GetWindowScaleFactorNative, _GetWindowScaleFactor>(
+            'window_size_get_window_scale_factor'),
+        _getMonitors = library.lookupFunction<_GetMonitorsNative, _GetMonitors>(
+            'window_size_get_monitors'),
+        _readGeometryMailbox = library.lookupFunction<
+                _ReadGeometryMailboxNative, _ReadGeometryMailbox>(
+            'window_size_read_geometry_mailbox',
+            isLeaf: true);
+
+  /// The bindings, or null if they are not available on this platform.
+  ///
+  /// Only implemented for Linux.
+  static final WindowSizeFfi? instance =
+      Platform.isLinux ? WindowSizeFfi._(DynamicLibrary.process()) : null;
+
+  final _GetWindowFrame _getWindowFrame;
+  final _GetWindowScaleFactor _getWindowScaleFactor;
+  final _GetMonitors _getMonitors;
+
+  final _ReadGeometryMailbox _readGeometryMailbox;
+
+  // Buffer the geometry mailbox is copied into. Allocated once, since the
+  // instance lives as long as the isolate.
+  final Pointer<_WindowSizeGeometryMailbox> _geometry =
+      calloc<_WindowSizeGeometryMailbox>();
+
+  /// Returns the frame of the window with [windowId], or null if there is no
+  /// such window.
+  Rect? getWindowFrame(int windowId) {
+    if (_getWindowScaleFactor(windowId) == 0.0) {
+      return null;
+    }
+    return _getWindowFrame(windowId).toRect();
+  }
+
+  /// Returns the scale factor of the window with [windowId], or null if there
+  /// is no such window.
+  double? getWindowScaleFactor(int windowId) {
+    final scaleFactor = _getWindowScaleFactor(windowId);
+    return scaleFactor == 0.0 ? null : scaleFactor;
+  }
+
+  /// Returns the screens, in the same order as getScreenList.
+  ///
+  /// All screens come from the same display configuration.
+  List<Screen> getScreenList() {
+    var capacity = _getMonitors(nullptr, 0);
+    while (true) {
+      final monitors = calloc<_WindowSizeMonitor>(capacity > 0 ? capacity : 1);
+      try {
+        // Each call copies from a single snapshot, so the list is consistent
+        // as long as it fits.
+        final count = _getMonitors(monitors, capacity);
+        if (count <= capacity) {
+          return [
+            for (var i = 0; i < count; i++)
+              Screen(monitors[i].frame.toRect(),
+                  monitors[i].visibleFrame.toRect(), monitors[i].scaleFactor),
+          ];
+        }
+        // Monitors were added since the count was read; try again.
+        capacity = count;
+      } finally {
+        calloc.free(monitors);
+      }
+    }
+  }
+
+  /// Returns the geometry of the window containing this Flutter instance, or
+  /// null if the window isn't known yet.
+  ///
+  /// This copies the plugin's geometry mailbox with a single leaf native
+  /// call, without a lock, so it is cheap enough to call every frame.
+  WindowGeometry? readGeometry() {
+    // The native reader does the sequence checks with the memory ordering
+    // needed for the copy to never be torn.
+    _readGeometryMailbox(_geometry);
+    final geometry = _geometry.ref;
+    if (geometry.windowId == 0) {
+      return null;
+    }
+    final monitorIndex = geometry.monitorIndex;
+    final monitor = geometry.monitor;
+    return WindowGeometry(
+        geometry.windowId,
+        geometry.frame.toRect(),
+        geometry.scaleFactor,
+        monitorIndex < 0 ? null : monitorIndex,
+        monitorIndex < 0
+            ? null
+            : Screen(monitor.frame.toRect(), monitor.visibleFrame.toRect(),
+                monitor.scaleFactor));
+  }
+}
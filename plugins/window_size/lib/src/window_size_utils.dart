@@ -12,11 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 import 'dart:async';
+import 'dart:typed_data';
 import 'dart:ui';
 
+import 'fullscreen_state.dart';
+import 'global_pointer_position.dart';
 import 'platform_window.dart';
+import 'rect_classification.dart';
+import 'resize_sync_stats.dart';
+import 'scale_factor_change.dart';
 import 'screen.dart';
+import 'window_geometry.dart';
+import 'window_group_layout.dart';
 import 'window_size_channel.dart';
+import 'window_size_ffi.dart';
 
 /// Returns a list of [Screen]s for the current screen configuration.
 ///
@@ -36,8 +45,20 @@ Future<Screen?> getCurrentScreen() async {
 }
 
 /// Returns information about the window containing this Flutter instance.
-Future<PlatformWindow> getWindowInfo() async {
-  return await WindowSizeChannel.instance.getWindowInfo();
+///
+/// If [windowId] is provided, returns information about that window instead.
+/// Window ids are only supported on Linux; see [getWindowList].
+Future<PlatformWindow> getWindowInfo({int? windowId}) async {
+  return await WindowSizeChannel.instance.getWindowInfo(windowId: windowId);
+}
+
+/// Returns the ids of the application's windows, for use as the `windowId`
+/// argument of the other functions.
+///
+/// Only implemented for Linux. Elsewhere, passing a `windowId` to a function
+/// that sends it to the platform throws an [UnsupportedError].
+Future<List<int>> getWindowList() async {
+  return await WindowSizeChannel.instance.getWindowList();
 }
 
 /// Sets the frame of the window containing this Flutter instance, in
@@ -46,28 +67,152 @@ Future<PlatformWindow> getWindowInfo() async {
 /// The platform may adjust the frame as necessary if the provided frame would
 /// cause significant usability issues (e.g., a window with no visible portion
 /// that can be used to move the window).
-void setWindowFrame(Rect frame) async {
-  WindowSizeChannel.instance.setWindowFrame(frame);
+void setWindowFrame(Rect frame, {int? windowId}) async {
+  WindowSizeChannel.instance.setWindowFrame(frame, windowId: windowId);
+}
+
+/// Returns statistics on how long it takes for resizes made with
+/// [setWindowFrame] to be applied by the window manager and painted.
+///
+/// This measures GTK's paint of the window, not the Flutter view's first
+/// frame at the new size, which the plugin can't observe. The view may
+/// briefly show its previous frame, stretched, after the paint.
+///
+/// Only implemented for Linux.
+Future<ResizeSyncStats> getResizeSyncStats({int? windowId}) async {
+  return WindowSizeChannel.instance.getResizeSyncStats(windowId: windowId);
 }
 
 /// Sets the minimum [Size] of the window containing this Flutter instance.
-void setWindowMinSize(Size size) async {
-  WindowSizeChannel.instance.setWindowMinSize(size);
+void setWindowMinSize(Size size, {int? windowId}) async {
+  WindowSizeChannel.instance.setWindowMinSize(size, windowId: windowId);
 }
 
 /// Sets the maximum [Size] of the window containing this Flutter instance.
-void setWindowMaxSize(Size size) async {
-  WindowSizeChannel.instance.setWindowMaxSize(size);
+void setWindowMaxSize(Size size, {int? windowId}) async {
+  WindowSizeChannel.instance.setWindowMaxSize(size, windowId: windowId);
 }
 
 /// Sets the window title, as a [String], of the window containing this Flutter instance.
-void setWindowTitle(String title) async {
-  WindowSizeChannel.instance.setWindowTitle(title);
+void setWindowTitle(String title, {int? windowId}) async {
+  WindowSizeChannel.instance.setWindowTitle(title, windowId: windowId);
+}
+
+/// Sets the window icon to a [width] by [height] image, given as [rgba] pixels
+/// in rows from top to bottom.
+///
+/// Recently used icons are cached by content, so switching between a few
+/// icons, e.g. to show status, is cheap.
+///
+/// Only implemented for Linux.
+void setWindowIcon(Uint8List rgba, int width, int height,
+    {int? windowId}) async {
+  WindowSizeChannel.instance
+      .setWindowIcon(rgba, width, height, windowId: windowId);
 }
 
 /// Shows or hides the window.
-void setWindowVisibility({required bool visible}) async {
-  WindowSizeChannel.instance.setWindowVisibility(visible: visible);
+void setWindowVisibility({required bool visible, int? windowId}) async {
+  WindowSizeChannel.instance
+      .setWindowVisibility(visible: visible, windowId: windowId);
+}
+
+/// Parks the window if [parked] is true, or reveals it if it is parked.
+///
+/// A parked window is invisible and ignores input, but unlike a window hidden
+/// with [setWindowVisibility] it stays mapped and ready to render, so
+/// revealing it is close to instant. Showing a parked window with
+/// [setWindowVisibility] also reveals it.
+///
+/// Only implemented for Linux.
+void setWindowParked(bool parked, {int? windowId}) async {
+  WindowSizeChannel.instance.setWindowParked(parked, windowId: windowId);
+}
+
+/// Enables or disables edge snapping while the window is moved.
+///
+/// While enabled, a window moved to within [threshold] of a snap target is
+/// pulled into line with it. Targets are the edges of each screen's
+/// [Screen.visibleFrame] and the edges of the application's other windows.
+/// Snapping is done natively once the window stops moving, without calls to
+/// Flutter.
+///
+/// Only implemented for Linux.
+void setWindowSnapping(bool enabled, {double? threshold, int? windowId}) async {
+  WindowSizeChannel.instance
+      .setWindowSnapping(enabled, threshold: threshold, windowId: windowId);
+}
+
+/// Makes the window fullscreen, or restores it.
+///
+/// The window fills the screen at [screenIndex] in [getScreenList], or its
+/// current screen if not given. With [bypassCompositor], a compositing window
+/// manager is asked to send the window's frames straight to the display while
+/// it is fullscreen, which avoids a frame of latency and a copy per frame.
+///
+/// Completes once the window manager has applied the change, with whether the
+/// window went fullscreen and whether the bypass request is in effect.
+///
+/// Only implemented for Linux.
+Future<FullscreenState> setWindowFullscreen(bool fullscreen,
+    {int? screenIndex, bool bypassCompositor = false, int? windowId}) async {
+  return WindowSizeChannel.instance.setWindowFullscreen(fullscreen,
+      screenIndex: screenIndex,
+      bypassCompositor: bypassCompositor,
+      windowId: windowId);
+}
+
+/// Enables or disables translating the state of the window containing this
+/// Flutter instance into engine lifecycle signals.
+///
+/// While enabled, hiding, iconifying or withdrawing the window moves the app
+/// to [AppLifecycleState.inactive] and then [AppLifecycleState.paused], and
+/// showing it again moves it back to [AppLifecycleState.resumed]. If the
+/// window stays in the background for [memoryPressureDelay] (ten seconds if
+/// not given), a memory pressure signal is sent so that the framework and
+/// engine release their caches; a negative delay never sends one.
+///
+/// Disabling the signals while the window is in the background resumes the
+/// app.
+///
+/// Only implemented for Linux.
+void setLifecycleSignals(bool enabled, {Duration? memoryPressureDelay}) async {
+  WindowSizeChannel.instance
+      .setLifecycleSignals(enabled, memoryPressureDelay: memoryPressureDelay);
+}
+
+/// Sets the number of secondary windows kept ready for [createWindow].
+///
+/// Pooled windows are created in the background and their engines started
+/// while hidden, so that creating a window only has to place and show one.
+/// If no window is created for [idleTimeout], the pool is emptied to save
+/// memory, and refilled after the next [createWindow].
+///
+/// Only implemented for Linux, where the runner must provide a window factory
+/// with window_size_plugin_set_window_factory.
+void configureWindowPool(int size, {Duration? idleTimeout}) async {
+  WindowSizeChannel.instance
+      .configureWindowPool(size, idleTimeout: idleTimeout);
+}
+
+/// Creates a secondary window running a new Flutter engine, with the given
+/// [frame] if any, and returns its id.
+///
+/// The window is taken from the pool configured by [configureWindowPool] if
+/// one is ready, and created from scratch otherwise.
+///
+/// Only implemented for Linux, where the runner must provide a window factory
+/// with window_size_plugin_set_window_factory.
+Future<int> createWindow({Rect? frame, bool visible = true}) async {
+  return WindowSizeChannel.instance
+      .createWindow(frame: frame, visible: visible);
+}
+
+/// Returns whether the window is parked; see [setWindowParked].
+///
+/// Only implemented for Linux.
+Future<bool> isWindowParked({int? windowId}) async {
+  return WindowSizeChannel.instance.isWindowParked(windowId: windowId);
 }
 
 /// Sets the window title's represented [Uri], of the window containing this Flutter instance.
@@ -79,11 +224,132 @@ void setWindowTitleRepresentedUrl(Uri url) async {
 }
 
 /// Gets the minimum [Size] of the window containing this Flutter instance.
-Future<Size> getWindowMinSize() async {
-  return WindowSizeChannel.instance.getWindowMinSize();
+Future<Size> getWindowMinSize({int? windowId}) async {
+  return WindowSizeChannel.instance.getWindowMinSize(windowId: windowId);
 }
 
 /// Gets the maximum [Size] of the window containing this Flutter instance.
-Future<Size> getWindowMaxSize() async {
-  return WindowSizeChannel.instance.getWindowMaxSize();
+Future<Size> getWindowMaxSize({int? windowId}) async {
+  return WindowSizeChannel.instance.getWindowMaxSize(windowId: windowId);
+}
+
+/// Returns, for each of [rects] (in screen coordinates), which of the screens
+/// returned by [getScreenList] it overlaps, and by how much.
+///
+/// Only implemented for Linux.
+Future<List<RectClassification>> classifyRects(List<Rect> rects) async {
+  return WindowSizeChannel.instance.classifyRects(rects);
+}
+
+/// Converts [points], in screen coordinates, from logical pixels to physical
+/// pixels, or the reverse if [toPhysical] is false.
+///
+/// Each point is converted with the scale factor of the screen it is on (see
+/// [Screen.scaleFactor]).
+///
+/// Only implemented for Linux.
+Future<List<Offset>> convertCoordinates(List<Offset> points,
+    {bool toPhysical = true}) async {
+  return WindowSizeChannel.instance
+      .convertCoordinates(points, toPhysical: toPhysical);
+}
+
+/// Maps [points], in the logical coordinates of the window's Flutter view,
+/// to screen coordinates.
+///
+/// The points are packed as [x0, y0, x1, y1, ...], and the result is packed
+/// the same way. The mapping uses the window position and scale factor
+/// cached natively, so it is cheap to call for many points,
+/// such as when positioning popups next to widgets, and is current even while
+/// the window moves. With [clampToScreen], results are kept within the
+/// [Screen.visibleFrame] of the window's screen. With [toPhysical], results
+/// are in physical rather than logical pixels.
+///
+/// Only implemented for Linux.
+Future<Float64List> transformPoints(Float64List points,
+    {bool clampToScreen = false,
+    bool toPhysical = false,
+    int? windowId}) async {
+  return WindowSizeChannel.instance.transformPoints(points,
+      clampToScreen: clampToScreen, toPhysical: toPhysical, windowId: windowId);
+}
+
+/// Arranges the windows with [windowIds] (see [getWindowList]) according to
+/// [layout], on the screen with [screenIndex] in [getScreenList] if provided.
+///
+/// All the windows are moved at once. Returns the frame given to each window.
+///
+/// Only implemented for Linux.
+Future<List<Rect>> setWindowGroupLayout(
+    List<int> windowIds, WindowGroupLayout layout,
+    {int? screenIndex}) async {
+  return WindowSizeChannel.instance
+      .setWindowGroupLayout(windowIds, layout, screenIndex: screenIndex);
+}
+
+/// Returns a stream of changes to the scale factor of the window containing
+/// this Flutter instance.
+///
+/// An event is sent once per change, when the window moves to a screen with a
+/// different scale or the display scale is changed, with the scale factors
+/// before and after the change.
+///
+/// Only implemented for Linux.
+Stream<ScaleFactorChange> scaleFactorChanges() {
+  return WindowSizeChannel.instance.scaleFactorChanges;
+}
+
+/// Returns a stream of the pointer's position on the desktop, even while it
+/// is outside of this Flutter instance's window.
+///
+/// The position is sampled once per frame, and only changes are reported.
+/// Sampling stops when the stream has no more listeners.
+///
+/// Only implemented for Linux.
+Stream<GlobalPointerPosition> globalPointerPositions() {
+  return WindowSizeChannel.instance.globalPointerPositions;
+}
+
+/// Returns the frame of the window containing this Flutter instance (or the
+/// window with [windowId]; see [getWindowList]) without waiting on the
+/// platform, or null if it is not available.
+///
+/// The frame is the window as seen on screen: it includes the window
+/// manager's decorations, but not the shadow drawn around windows with
+/// client-side decorations. It can be compared with the frames of other
+/// windows and with [Screen.visibleFrame], but may differ slightly from
+/// [getWindowInfo]'s frame.
+///
+/// Only implemented for Linux.
+Rect? getWindowFrameSync({int windowId = 0}) {
+  return WindowSizeFfi.instance?.getWindowFrame(windowId);
+}
+
+/// Returns the scale factor of the window containing this Flutter instance
+/// (or the window with [windowId]) without waiting on the platform, or null
+/// if it is not available.
+///
+/// Only implemented for Linux.
+double? getWindowScaleFactorSync({int windowId = 0}) {
+  return WindowSizeFfi.instance?.getWindowScaleFactor(windowId);
+}
+
+/// Returns the same list as [getScreenList] without waiting on the platform.
+///
+/// Only implemented for Linux; returns an empty list elsewhere.
+List<Screen> getScreenListSync() {
+  return WindowSizeFfi.instance?.getScreenList() ?? [];
+}
+
+/// Returns the geometry of the window containing this Flutter instance, or
+/// null if it is not available.
+///
+/// This copies the geometry from memory shared with the plugin with a single
+/// leaf FFI call (window_size_read_geometry_mailbox), which takes no locks and
+/// doesn't wait on the platform thread, so it is cheap enough to poll every
+/// frame.
+///
+/// Only implemented for Linux.
+WindowGeometry? readWindowGeometry() {
+  return WindowSizeFfi.instance?.readGeometry();
 }
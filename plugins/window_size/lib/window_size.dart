@@ -11,6 +11,14 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
+export 'src/frame_extents.dart';
+export 'src/fullscreen_state.dart';
+export 'src/global_pointer_position.dart';
 export 'src/platform_window.dart';
+export 'src/rect_classification.dart';
+export 'src/resize_sync_stats.dart';
+export 'src/scale_factor_change.dart';
 export 'src/screen.dart';
+export 'src/window_geometry.dart';
+export 'src/window_group_layout.dart';
 export 'src/window_size_utils.dart';
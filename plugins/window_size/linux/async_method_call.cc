@@ -0,0 +1,177 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "async_method_call.h"
+
+struct _AsyncMethodQueue {
+  // Number of references; one for the owner and one for each call in
+  // progress. Only used on the main thread.
+  gint ref_count;
+
+  // Cancelled when the owner frees the queue.
+  GCancellable* cancellable;
+
+  // GQueue of AsyncMethodCall by method name. The head of each queue is in
+  // progress, the rest are waiting for it.
+  GHashTable* calls;
+};
+
+typedef struct {
+  AsyncMethodQueue* queue;
+  FlMethodCall* method_call;
+  AsyncMethodFunc func;
+  gpointer data;
+  GDestroyNotify data_destroy;
+  gboolean in_thread;
+} AsyncMethodCall;
+
+static void async_method_queue_unref(AsyncMethodQueue* queue) {
+  if (--queue->ref_count > 0) return;
+  g_object_unref(queue->cancellable);
+  g_hash_table_unref(queue->calls);
+  g_free(queue);
+}
+
+static void async_method_call_free(AsyncMethodCall* call) {
+  g_object_unref(call->method_call);
+  if (call->data_destroy != nullptr) call->data_destroy(call->data);
+  g_free(call);
+}
+
+static void start_call(AsyncMethodCall* call);
+
+// Sends |response| for |call| and starts the next call to the same method.
+static void complete_call(AsyncMethodCall* call, FlMethodResponse* response) {
+  AsyncMethodQueue* queue = call->queue;
+  gboolean cancelled = g_cancellable_is_cancelled(queue->cancellable);
+
+  if (!cancelled && response != nullptr) {
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(call->method_call, response, &error))
+      g_warning("Failed to send method call response: %s", error->message);
+  }
+
+  // Keep the method name alive until the calls are looked up.
+  g_autofree gchar* method =
+      g_strdup(fl_method_call_get_name(call->method_call));
+  GQueue* calls =
+      static_cast<GQueue*>(g_hash_table_lookup(queue->calls, method));
+  g_queue_pop_head(calls);
+  async_method_call_free(call);
+
+  if (cancelled) {
+    // Drop the calls that were waiting, releasing their references.
+    AsyncMethodCall* waiting;
+    while ((waiting = static_cast<AsyncMethodCall*>(g_queue_pop_head(calls))) !=
+           nullptr) {
+      async_method_call_free(waiting);
+      queue->ref_count--;
+    }
+  }
+
+  if (g_queue_is_empty(calls)) {
+    g_hash_table_remove(queue->calls, method);
+  } else {
+    start_call(static_cast<AsyncMethodCall*>(g_queue_peek_head(calls)));
+  }
+
+  async_method_queue_unref(queue);
+}
+
+static void thread_func(GTask* task, gpointer source_object, gpointer task_data,
+                        GCancellable* cancellable) {
+  AsyncMethodCall* call = static_cast<AsyncMethodCall*>(task_data);
+  g_task_return_pointer(task, call->func(call->data, cancellable),
+                        g_object_unref);
+}
+
+static void thread_done_cb(GObject* object, GAsyncResult* result,
+                           gpointer user_data) {
+  AsyncMethodCall* call = static_cast<AsyncMethodCall*>(user_data);
+  g_autoptr(FlMethodResponse) response = static_cast<FlMethodResponse*>(
+      g_task_propagate_pointer(G_TASK(result), nullptr));
+  complete_call(call, response);
+}
+
+static gboolean main_idle_cb(gpointer user_data) {
+  AsyncMethodCall* call = static_cast<AsyncMethodCall*>(user_data);
+  g_autoptr(FlMethodResponse) response = nullptr;
+  if (!g_cancellable_is_cancelled(call->queue->cancellable)) {
+    response = call->func(call->data, call->queue->cancellable);
+  }
+  complete_call(call, response);
+  return G_SOURCE_REMOVE;
+}
+
+static void start_call(AsyncMethodCall* call) {
+  if (call->in_thread) {
+    g_autoptr(GTask) task = g_task_new(nullptr, call->queue->cancellable,
+                                       thread_done_cb, call);
+    g_task_set_task_data(task, call, nullptr);
+    g_task_run_in_thread(task, thread_func);
+  } else {
+    g_idle_add(main_idle_cb, call);
+  }
+}
+
+static void enqueue_call(AsyncMethodQueue* queue, FlMethodCall* method_call,
+                         AsyncMethodFunc func, gpointer data,
+                         GDestroyNotify data_destroy, gboolean in_thread) {
+  AsyncMethodCall* call = g_new0(AsyncMethodCall, 1);
+  call->queue = queue;
+  call->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+  call->func = func;
+  call->data = data;
+  call->data_destroy = data_destroy;
+  call->in_thread = in_thread;
+  queue->ref_count++;
+
+  const gchar* method = fl_method_call_get_name(method_call);
+  GQueue* calls =
+      static_cast<GQueue*>(g_hash_table_lookup(queue->calls, method));
+  if (calls == nullptr) {
+    calls = g_queue_new();
+    g_hash_table_insert(queue->calls, g_strdup(method), calls);
+  }
+  g_queue_push_tail(calls, call);
+  if (g_queue_get_length(calls) == 1) start_call(call);
+}
+
+AsyncMethodQueue* async_method_queue_new() {
+  AsyncMethodQueue* queue = g_new0(AsyncMethodQueue, 1);
+  queue->ref_count = 1;
+  queue->cancellable = g_cancellable_new();
+  queue->calls = g_hash_table_new_full(
+      g_str_hash, g_str_equal, g_free,
+      reinterpret_cast<GDestroyNotify>(g_queue_free));
+  return queue;
+}
+
+void async_method_queue_free(AsyncMethodQueue* queue) {
+  g_cancellable_cancel(queue->cancellable);
+  async_method_queue_unref(queue);
+}
+
+void async_method_queue_run_in_thread(AsyncMethodQueue* queue,
+                                      FlMethodCall* method_call,
+                                      AsyncMethodFunc func, gpointer data,
+                                      GDestroyNotify data_destroy) {
+  enqueue_call(queue, method_call, func, data, data_destroy, TRUE);
+}
+
+void async_method_queue_run_on_main(AsyncMethodQueue* queue,
+                                    FlMethodCall* method_call,
+                                    AsyncMethodFunc func, gpointer data,
+                                    GDestroyNotify data_destroy) {
+  enqueue_call(queue, method_call, func, data, data_destroy, FALSE);
+}
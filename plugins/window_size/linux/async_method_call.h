@@ -0,0 +1,60 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PLUGINS_WINDOW_SIZE_LINUX_ASYNC_METHOD_CALL_H_
+#define PLUGINS_WINDOW_SIZE_LINUX_ASYNC_METHOD_CALL_H_
+
+// Responding to method calls without blocking the GTK main loop.
+//
+// A call's response is computed either on a worker thread or in a later
+// main loop iteration, and sent from the main loop once it is ready. Calls to
+// the same method are handled one at a time, in the order they arrived, so
+// their responses are sent in order too; calls to different methods may
+// complete in any order.
+
+#include <flutter_linux/flutter_linux.h>
+
+G_BEGIN_DECLS
+
+// Computes the response to a method call. |data| is the data passed to
+// async_method_queue_run_*. If |cancellable| is cancelled the response is
+// discarded, so long running functions may check it to stop early.
+typedef FlMethodResponse* (*AsyncMethodFunc)(gpointer data,
+                                             GCancellable* cancellable);
+
+typedef struct _AsyncMethodQueue AsyncMethodQueue;
+
+// Creates a queue, to be freed with async_method_queue_free.
+AsyncMethodQueue* async_method_queue_new();
+
+// Frees |queue|. Calls still in progress are cancelled and not responded to.
+void async_method_queue_free(AsyncMethodQueue* queue);
+
+// Responds to |method_call| with the result of calling |func| on a worker
+// thread. |func| must not use GTK or GDK. |data_destroy|, if not null, is
+// called on the main thread once |data| is no longer needed.
+void async_method_queue_run_in_thread(AsyncMethodQueue* queue,
+                                      FlMethodCall* method_call,
+                                      AsyncMethodFunc func, gpointer data,
+                                      GDestroyNotify data_destroy);
+
+// As async_method_queue_run_in_thread, but calls |func| on the main thread
+// from an idle source, letting pending input be handled first.
+void async_method_queue_run_on_main(AsyncMethodQueue* queue,
+                                    FlMethodCall* method_call,
+                                    AsyncMethodFunc func, gpointer data,
+                                    GDestroyNotify data_destroy);
+
+G_END_DECLS
+
+#endif  // PLUGINS_WINDOW_SIZE_LINUX_ASYNC_METHOD_CALL_H_
@@ -0,0 +1,108 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PLUGINS_WINDOW_SIZE_LINUX_DISPLAY_SNAPSHOT_H_
+#define PLUGINS_WINDOW_SIZE_LINUX_DISPLAY_SNAPSHOT_H_
+
+// Immutable snapshots of the display topology and window geometry, for
+// native code on any thread.
+//
+// The plugin builds a new snapshot on the GTK main thread whenever the state
+// changes and publishes it with an atomic pointer swap. Acquiring the current
+// snapshot is wait-free; a snapshot stays valid until it is released, and the
+// plugin frees each replaced snapshot on the main thread once no reader holds
+// it. Holding a snapshot only keeps that one snapshot alive.
+
+#include "window_size_ffi.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// A window in a snapshot.
+typedef struct {
+  int64_t id;
+  WindowSizeRect frame;
+  double scale_factor;
+  // Index into the snapshot's monitors, or -1 if unknown.
+  int32_t monitor_index;
+} WindowSizeWindowSnapshot;
+
+// The display topology and window geometry at one point in time.
+typedef struct {
+  // Increases by one with each published snapshot.
+  uint64_t generation;
+  // Id of the window containing the Flutter view, or 0 if not yet known.
+  int64_t default_window_id;
+  // Monitors, in getScreenList order.
+  const WindowSizeMonitor* monitors;
+  int32_t n_monitors;
+  const WindowSizeWindowSnapshot* windows;
+  int32_t n_windows;
+} WindowSizeDisplaySnapshot;
+
+// Gets the current snapshot, which must be passed to
+// window_size_display_snapshot_release when no longer needed. Never returns
+// null.
+WINDOW_SIZE_FFI_EXPORT const WindowSizeDisplaySnapshot*
+window_size_display_snapshot_acquire(void);
+
+// Releases a snapshot returned by window_size_display_snapshot_acquire.
+WINDOW_SIZE_FFI_EXPORT void window_size_display_snapshot_release(
+    const WindowSizeDisplaySnapshot* snapshot);
+
+#if defined(__cplusplus)
+}  // extern "C"
+
+namespace window_size {
+
+// Holds the current display snapshot for the lifetime of this object.
+//
+//   window_size::DisplaySnapshot snapshot;
+//   for (int32_t i = 0; i < snapshot->n_monitors; i++) { ... }
+class DisplaySnapshot {
+ public:
+  DisplaySnapshot() : snapshot_(window_size_display_snapshot_acquire()) {}
+  ~DisplaySnapshot() { window_size_display_snapshot_release(snapshot_); }
+
+  DisplaySnapshot(const DisplaySnapshot&) = delete;
+  DisplaySnapshot& operator=(const DisplaySnapshot&) = delete;
+
+  const WindowSizeDisplaySnapshot* operator->() const { return snapshot_; }
+  const WindowSizeDisplaySnapshot& operator*() const { return *snapshot_; }
+
+  // Gets the window with |window_id|, or nullptr if there is no such window.
+  // As with the method channel, id 0 is the window containing the view.
+  const WindowSizeWindowSnapshot* FindWindow(int64_t window_id) const {
+    if (window_id == 0) window_id = snapshot_->default_window_id;
+    for (int32_t i = 0; i < snapshot_->n_windows; i++) {
+      if (snapshot_->windows[i].id == window_id) return &snapshot_->windows[i];
+    }
+    return nullptr;
+  }
+
+  // Gets the monitor at |index|, or nullptr if |index| is out of range.
+  const WindowSizeMonitor* GetMonitor(int32_t index) const {
+    if (index < 0 || index >= snapshot_->n_monitors) return nullptr;
+    return &snapshot_->monitors[index];
+  }
+
+ private:
+  const WindowSizeDisplaySnapshot* snapshot_;
+};
+
+}  // namespace window_size
+
+#endif  // defined(__cplusplus)
+
+#endif  // PLUGINS_WINDOW_SIZE_LINUX_DISPLAY_SNAPSHOT_H_
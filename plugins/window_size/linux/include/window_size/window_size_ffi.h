@@ -0,0 +1,113 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PLUGINS_WINDOW_SIZE_LINUX_WINDOW_SIZE_FFI_H_
+#define PLUGINS_WINDOW_SIZE_LINUX_WINDOW_SIZE_FFI_H_
+
+// A C ABI for synchronous window geometry queries, e.g. from dart:ffi.
+//
+// The functions read a snapshot that the plugin updates on the GTK main
+// thread whenever geometry changes, so they can be called from any thread
+// and never block on the main loop. Window ids are those reported by the
+// getWindowInfo and getWindowList methods; as with those methods, id 0 is the
+// window containing the Flutter view.
+//
+// See window_size_ffi.dart for the Dart bindings; the layout of these structs
+// must be kept in sync with it.
+
+#include <stdint.h>
+
+#ifdef FLUTTER_PLUGIN_IMPL
+#define WINDOW_SIZE_FFI_EXPORT __attribute__((visibility("default")))
+#else
+#define WINDOW_SIZE_FFI_EXPORT
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// A rectangle in screen coordinates.
+typedef struct {
+  double x;
+  double y;
+  double width;
+  double height;
+} WindowSizeRect;
+
+// A monitor, as reported by getScreenList.
+typedef struct {
+  WindowSizeRect frame;
+  WindowSizeRect visible_frame;
+  double scale_factor;
+} WindowSizeMonitor;
+
+// The geometry of the window containing the Flutter view, published without
+// locks for callers that poll it at a high rate, such as once per frame.
+//
+// The plugin is the only writer. It increments |sequence| before and after
+// each update, so |sequence| is odd while an update is in progress. To read:
+// load |sequence|, retrying while it is odd; copy the fields; then load
+// |sequence| again, and retry if it changed. Callers should use
+// window_size_read_geometry_mailbox, which does this with the required memory
+// barriers; plain loads, such as Dart struct field reads, don't order the
+// field reads against the sequence reads and can return torn values.
+typedef struct {
+  uint32_t sequence;
+  // Index of |monitor| in the getScreenList order, or -1 if unknown.
+  int32_t monitor_index;
+  // Id of the window, or 0 before the window is known.
+  int64_t window_id;
+  WindowSizeRect frame;
+  double scale_factor;
+  WindowSizeMonitor monitor;
+} WindowSizeGeometryMailbox;
+
+// Gets the frame of the window with |window_id|, or an empty rect if there is
+// no such window. The frame includes the window manager's decorations but not
+// any client-side decoration shadow, for every window.
+WINDOW_SIZE_FFI_EXPORT WindowSizeRect
+window_size_get_window_frame(int64_t window_id);
+
+// Gets the scale factor of the window with |window_id|, or 0 if there is no
+// such window.
+WINDOW_SIZE_FFI_EXPORT double window_size_get_window_scale_factor(
+    int64_t window_id);
+
+// Gets the number of monitors.
+WINDOW_SIZE_FFI_EXPORT int32_t window_size_get_monitor_count(void);
+
+// Gets the monitor at |index|, in getScreenList order, or a zeroed monitor if
+// |index| is out of range.
+WINDOW_SIZE_FFI_EXPORT WindowSizeMonitor
+window_size_get_monitor(int32_t index);
+
+// Copies up to |capacity| monitors into |monitors|, returning the total
+// number of monitors. All monitors come from the same snapshot.
+WINDOW_SIZE_FFI_EXPORT int32_t
+window_size_get_monitors(WindowSizeMonitor* monitors, int32_t capacity);
+
+// Gets the geometry mailbox. The pointer is valid for the lifetime of the
+// process.
+WINDOW_SIZE_FFI_EXPORT const WindowSizeGeometryMailbox*
+window_size_get_geometry_mailbox(void);
+
+// Copies a consistent view of the geometry mailbox into |geometry|.
+WINDOW_SIZE_FFI_EXPORT void window_size_read_geometry_mailbox(
+    WindowSizeGeometryMailbox* geometry);
+
+#if defined(__cplusplus)
+}  // extern "C"
+#endif
+
+#endif  // PLUGINS_WINDOW_SIZE_LINUX_WINDOW_SIZE_FFI_H_
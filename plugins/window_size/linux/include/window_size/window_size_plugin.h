@@ -35,6 +35,21 @@ FLUTTER_PLUGIN_EXPORT FlWindowSizePlugin* fl_window_size_plugin_new(
 FLUTTER_PLUGIN_EXPORT void window_size_plugin_register_with_registrar(
     FlPluginRegistrar* registrar);
 
+// Creates a secondary window for the window pool: a new toplevel containing
+// an FlView with plugins registered, not yet shown. |user_data| is the data
+// passed to window_size_plugin_set_window_factory.
+typedef GtkWindow* (*WindowSizeWindowFactory)(gpointer user_data);
+
+// Sets the function used to create windows for the createWindow method.
+//
+// Windows are created ahead of time and realized while hidden, so that the
+// engine is running and a created window only has to be placed and shown.
+// Without a factory, createWindow fails. |destroy_notify|, if not null, is
+// called on |user_data| when the factory is replaced.
+FLUTTER_PLUGIN_EXPORT void window_size_plugin_set_window_factory(
+    WindowSizeWindowFactory factory, gpointer user_data,
+    GDestroyNotify destroy_notify);
+
 G_END_DECLS
 
 #endif  // PLUGINS_WINDOW_SIZE_LINUX_WINDOW_SIZE_PLUGIN_H_
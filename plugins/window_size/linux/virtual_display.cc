@@ -0,0 +1,180 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "virtual_display.h"
+
+#include <cstring>
+
+// Environment variable naming the key file to load the model from.
+const char kVirtualDisplayEnvironmentVariable[] = "WINDOW_SIZE_VIRTUAL_DISPLAY";
+
+const char kMonitorGroupPrefix[] = "Monitor";
+const char kWindowGroup[] = "Window";
+const char kFrameKey[] = "Frame";
+const char kVisibleFrameKey[] = "VisibleFrame";
+const char kScaleFactorKey[] = "ScaleFactor";
+const char kTitleKey[] = "Title";
+const char kVisibleKey[] = "Visible";
+
+// The model used when no key file is given.
+const WindowSizeMonitor kDefaultMonitor = {
+    {0, 0, 1920, 1080}, {0, 0, 1920, 1080}, 1.0};
+const WindowSizeRect kDefaultWindowFrame = {0, 0, 1280, 720};
+
+// Reads a [x, y, width, height] list from |key_file|. Returns FALSE if it is
+// missing or malformed.
+static gboolean get_rect(GKeyFile* key_file, const gchar* group,
+                         const gchar* key, WindowSizeRect* rect,
+                         GError** error) {
+  gsize length;
+  g_autofree gdouble* values =
+      g_key_file_get_double_list(key_file, group, key, &length, error);
+  if (values == nullptr) return FALSE;
+  if (length != 4 || values[2] < 0 || values[3] < 0) {
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                "%s in [%s] must be x;y;width;height", key, group);
+    return FALSE;
+  }
+  *rect = {values[0], values[1], values[2], values[3]};
+  return TRUE;
+}
+
+// Reads a positive scale factor from |key_file|, defaulting to 1.
+static gboolean get_scale_factor(GKeyFile* key_file, const gchar* group,
+                                 double* scale_factor, GError** error) {
+  *scale_factor = 1.0;
+  if (!g_key_file_has_key(key_file, group, kScaleFactorKey, nullptr)) {
+    return TRUE;
+  }
+  *scale_factor =
+      g_key_file_get_double(key_file, group, kScaleFactorKey, error);
+  if (*scale_factor <= 0) {
+    g_clear_error(error);
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                "%s in [%s] must be positive", kScaleFactorKey, group);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// Loads the model from the key file at |path|.
+static gboolean load_virtual_display(VirtualDisplay* display,
+                                     const gchar* path, GError** error) {
+  g_autoptr(GKeyFile) key_file = g_key_file_new();
+  if (!g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, error)) {
+    return FALSE;
+  }
+
+  gsize n_groups;
+  g_auto(GStrv) groups = g_key_file_get_groups(key_file, &n_groups);
+  g_autoptr(GArray) monitors =
+      g_array_new(FALSE, TRUE, sizeof(WindowSizeMonitor));
+  for (gsize i = 0; i < n_groups; i++) {
+    if (!g_str_has_prefix(groups[i], kMonitorGroupPrefix)) continue;
+
+    WindowSizeMonitor monitor;
+    if (!get_rect(key_file, groups[i], kFrameKey, &monitor.frame, error) ||
+        !get_scale_factor(key_file, groups[i], &monitor.scale_factor,
+                          error)) {
+      return FALSE;
+    }
+    monitor.visible_frame = monitor.frame;
+    if (g_key_file_has_key(key_file, groups[i], kVisibleFrameKey, nullptr) &&
+        !get_rect(key_file, groups[i], kVisibleFrameKey,
+                  &monitor.visible_frame, error)) {
+      return FALSE;
+    }
+    g_array_append_val(monitors, monitor);
+  }
+  if (monitors->len == 0) {
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_GROUP_NOT_FOUND,
+                "No [%s] groups", kMonitorGroupPrefix);
+    return FALSE;
+  }
+
+  if (g_key_file_has_key(key_file, kWindowGroup, kFrameKey, nullptr) &&
+      !get_rect(key_file, kWindowGroup, kFrameKey, &display->window_frame,
+                error)) {
+    return FALSE;
+  }
+  if (g_key_file_has_key(key_file, kWindowGroup, kTitleKey, nullptr)) {
+    g_free(display->window_title);
+    display->window_title =
+        g_key_file_get_string(key_file, kWindowGroup, kTitleKey, nullptr);
+  }
+  if (g_key_file_has_key(key_file, kWindowGroup, kVisibleKey, nullptr)) {
+    display->window_visible =
+        g_key_file_get_boolean(key_file, kWindowGroup, kVisibleKey, nullptr);
+  }
+
+  g_free(display->monitors);
+  display->n_monitors = monitors->len;
+  display->monitors = reinterpret_cast<WindowSizeMonitor*>(
+      g_array_free(static_cast<GArray*>(g_steal_pointer(&monitors)), FALSE));
+  return TRUE;
+}
+
+VirtualDisplay* virtual_display_new() {
+  VirtualDisplay* display = g_new0(VirtualDisplay, 1);
+  display->monitors = g_new(WindowSizeMonitor, 1);
+  display->monitors[0] = kDefaultMonitor;
+  display->n_monitors = 1;
+  display->window_frame = kDefaultWindowFrame;
+  display->window_title = g_strdup("");
+  display->window_visible = TRUE;
+  display->min_width = -1;
+  display->min_height = -1;
+  display->max_width = G_MAXINT;
+  display->max_height = G_MAXINT;
+
+  const gchar* path = g_getenv(kVirtualDisplayEnvironmentVariable);
+  if (path != nullptr && path[0] != '\0') {
+    g_autoptr(GError) error = nullptr;
+    if (!load_virtual_display(display, path, &error)) {
+      g_warning("Failed to load virtual display from %s: %s", path,
+                error->message);
+    }
+  }
+
+  return display;
+}
+
+void virtual_display_free(VirtualDisplay* display) {
+  g_free(display->monitors);
+  g_free(display->window_title);
+  g_free(display);
+}
+
+gboolean virtual_display_set_window_frame(VirtualDisplay* display,
+                                          const WindowSizeRect* frame) {
+  double width = CLAMP(frame->width, MAX(display->min_width, 0),
+                       static_cast<double>(display->max_width));
+  double height = CLAMP(frame->height, MAX(display->min_height, 0),
+                        static_cast<double>(display->max_height));
+  gboolean resized = width != display->window_frame.width ||
+                     height != display->window_frame.height;
+  display->window_frame = {frame->x, frame->y, width, height};
+  return resized;
+}
+
+gint virtual_display_get_window_monitor(VirtualDisplay* display) {
+  const WindowSizeRect* window = &display->window_frame;
+  for (gint i = 0; i < display->n_monitors; i++) {
+    const WindowSizeRect* frame = &display->monitors[i].frame;
+    if (window->x >= frame->x && window->x < frame->x + frame->width &&
+        window->y >= frame->y && window->y < frame->y + frame->height) {
+      return i;
+    }
+  }
+  return 0;
+}
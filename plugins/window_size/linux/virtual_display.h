@@ -0,0 +1,91 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PLUGINS_WINDOW_SIZE_LINUX_VIRTUAL_DISPLAY_H_
+#define PLUGINS_WINDOW_SIZE_LINUX_VIRTUAL_DISPLAY_H_
+
+// A model of a display and a window, used in place of GDK when the plugin has
+// no view, e.g. when the engine is running headless.
+//
+// The model is loaded from the key file named by the
+// WINDOW_SIZE_VIRTUAL_DISPLAY environment variable, for example:
+//
+//   [Monitor 0]
+//   Frame=0;0;1920;1080
+//   VisibleFrame=0;32;1920;1048
+//   ScaleFactor=1.0
+//
+//   [Monitor 1]
+//   Frame=1920;0;2560;1440
+//   ScaleFactor=1.5
+//
+//   [Window]
+//   Frame=100;100;1280;720
+//   Title=Example
+//   Visible=true
+//
+// Monitors are listed in file order. VisibleFrame defaults to Frame, and
+// ScaleFactor to 1. Without the variable, a single 1920x1080 monitor with a
+// 1280x720 window is used.
+
+#include <glib.h>
+
+#include "include/window_size/window_size_ffi.h"
+
+G_BEGIN_DECLS
+
+typedef struct {
+  // Monitors, in getScreenList order.
+  WindowSizeMonitor* monitors;
+  gint n_monitors;
+
+  // The virtual window, which has the same semantics as the real one.
+  gint64 window_id;
+  WindowSizeRect window_frame;
+  gchar* window_title;
+  gboolean window_visible;
+  gboolean window_parked;
+
+  // TRUE if the window fills its monitor, in which case restore_frame is the
+  // frame it had before.
+  gboolean window_fullscreen;
+  WindowSizeRect restore_frame;
+
+  // Size limits, using -1 and G_MAXINT for unconstrained as GdkGeometry does.
+  gint min_width;
+  gint min_height;
+  gint max_width;
+  gint max_height;
+
+  // Number of setWindowFrame calls that changed the window size.
+  gint64 resize_count;
+} VirtualDisplay;
+
+// Creates a virtual display as described above, to be freed with
+// virtual_display_free.
+VirtualDisplay* virtual_display_new();
+
+void virtual_display_free(VirtualDisplay* display);
+
+// Sets the frame of the virtual window, applying its size limits. Returns
+// TRUE if the window size changed.
+gboolean virtual_display_set_window_frame(VirtualDisplay* display,
+                                          const WindowSizeRect* frame);
+
+// Gets the index of the monitor showing the virtual window: the one
+// containing its top left corner, or else the first.
+gint virtual_display_get_window_monitor(VirtualDisplay* display);
+
+G_END_DECLS
+
+#endif  // PLUGINS_WINDOW_SIZE_LINUX_VIRTUAL_DISPLAY_H_
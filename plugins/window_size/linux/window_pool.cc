@@ -0,0 +1,187 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "window_pool.h"
+
+// Key used to attach a pooled window's application while it is detached.
+static const char kApplicationDataKey[] = "window-pool-application";
+
+typedef struct {
+  WindowSizeWindowFactory factory;
+  gpointer user_data;
+  GDestroyNotify destroy_notify;
+
+  // Windows ready to be checked out, oldest first. Each holds a reference.
+  GQueue windows;
+
+  // Number of windows to keep ready.
+  guint size;
+
+  // Time without a checkout after which the pool is emptied, or 0.
+  guint idle_timeout_ms;
+
+  // TRUE if the pool has been emptied after the idle timeout, in which case
+  // it isn't refilled until the next checkout.
+  gboolean trimmed;
+
+  guint fill_source;
+  guint trim_source;
+} WindowPool;
+
+static WindowPool pool = {};
+
+// Called when a window is destroyed while in the pool, e.g. on shutdown.
+static void pooled_window_destroy_cb(GtkWindow* window, gpointer user_data) {
+  if (g_queue_remove(&pool.windows, window)) g_object_unref(window);
+}
+
+// Creates a window with the factory and starts its engine. Returns a new
+// reference, or nullptr if the factory failed.
+static GtkWindow* create_window() {
+  GtkWindow* window = pool.factory(pool.user_data);
+  if (window == nullptr) return nullptr;
+  g_object_ref(window);
+
+  // Realizing the view starts its engine, so the window only needs a first
+  // frame once shown.
+  gtk_widget_realize(GTK_WIDGET(window));
+  GtkWidget* child = gtk_bin_get_child(GTK_BIN(window));
+  if (child != nullptr) gtk_widget_realize(child);
+
+  return window;
+}
+
+// Adds |window| to the pool, taking its reference.
+static void add_window(GtkWindow* window) {
+  GtkApplication* application = gtk_window_get_application(window);
+  if (application != nullptr) {
+    g_object_set_data_full(G_OBJECT(window), kApplicationDataKey,
+                           g_object_ref(application), g_object_unref);
+    gtk_window_set_application(window, nullptr);
+  }
+  g_signal_connect(window, "destroy", G_CALLBACK(pooled_window_destroy_cb),
+                   nullptr);
+  g_queue_push_tail(&pool.windows, window);
+}
+
+// Takes |window| out of the pool, keeping its reference.
+static void remove_window(GtkWindow* window) {
+  g_signal_handlers_disconnect_by_func(
+      window, reinterpret_cast<gpointer>(pooled_window_destroy_cb), nullptr);
+  GtkApplication* application = GTK_APPLICATION(
+      g_object_steal_data(G_OBJECT(window), kApplicationDataKey));
+  if (application != nullptr) {
+    gtk_window_set_application(window, application);
+    g_object_unref(application);
+  }
+}
+
+// Destroys pooled windows, oldest first, until at most |size| remain.
+static void shrink_pool(guint size) {
+  while (g_queue_get_length(&pool.windows) > size) {
+    GtkWindow* window = GTK_WINDOW(g_queue_pop_head(&pool.windows));
+    g_signal_handlers_disconnect_by_func(
+        window, reinterpret_cast<gpointer>(pooled_window_destroy_cb), nullptr);
+    gtk_widget_destroy(GTK_WIDGET(window));
+    g_object_unref(window);
+  }
+}
+
+// Creates one window, continuing from later idle iterations until the pool
+// is full.
+static gboolean fill_cb(gpointer user_data) {
+  if (pool.factory == nullptr || pool.trimmed ||
+      g_queue_get_length(&pool.windows) >= pool.size) {
+    pool.fill_source = 0;
+    return G_SOURCE_REMOVE;
+  }
+
+  GtkWindow* window = create_window();
+  if (window == nullptr) {
+    g_warning("Window factory failed; not filling the window pool");
+    pool.fill_source = 0;
+    return G_SOURCE_REMOVE;
+  }
+  add_window(window);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void schedule_fill() {
+  if (pool.fill_source != 0 || pool.factory == nullptr || pool.trimmed ||
+      g_queue_get_length(&pool.windows) >= pool.size) {
+    return;
+  }
+  pool.fill_source =
+      g_idle_add_full(G_PRIORITY_LOW, fill_cb, nullptr, nullptr);
+}
+
+// Called when the pool has gone the idle timeout without a checkout.
+static gboolean trim_cb(gpointer user_data) {
+  pool.trim_source = 0;
+  pool.trimmed = TRUE;
+  g_clear_handle_id(&pool.fill_source, g_source_remove);
+  shrink_pool(0);
+  return G_SOURCE_REMOVE;
+}
+
+static void restart_trim_timeout() {
+  g_clear_handle_id(&pool.trim_source, g_source_remove);
+  if (pool.idle_timeout_ms > 0) {
+    pool.trim_source = g_timeout_add(pool.idle_timeout_ms, trim_cb, nullptr);
+  }
+}
+
+void window_pool_set_factory(WindowSizeWindowFactory factory,
+                             gpointer user_data,
+                             GDestroyNotify destroy_notify) {
+  // Windows from the old factory may not suit the new one.
+  g_clear_handle_id(&pool.fill_source, g_source_remove);
+  shrink_pool(0);
+  if (pool.destroy_notify != nullptr) pool.destroy_notify(pool.user_data);
+
+  pool.factory = factory;
+  pool.user_data = user_data;
+  pool.destroy_notify = destroy_notify;
+  schedule_fill();
+}
+
+gboolean window_pool_has_factory() { return pool.factory != nullptr; }
+
+void window_pool_configure(guint size, guint idle_timeout_ms) {
+  pool.size = size;
+  pool.idle_timeout_ms = idle_timeout_ms;
+  pool.trimmed = FALSE;
+  shrink_pool(size);
+  restart_trim_timeout();
+  schedule_fill();
+}
+
+guint window_pool_get_available() { return g_queue_get_length(&pool.windows); }
+
+GtkWindow* window_pool_checkout() {
+  if (pool.factory == nullptr) return nullptr;
+
+  pool.trimmed = FALSE;
+  restart_trim_timeout();
+
+  GtkWindow* window = GTK_WINDOW(g_queue_pop_head(&pool.windows));
+  if (window != nullptr) {
+    remove_window(window);
+  } else {
+    window = create_window();
+  }
+  schedule_fill();
+
+  return window;
+}
@@ -0,0 +1,54 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PLUGINS_WINDOW_SIZE_LINUX_WINDOW_POOL_H_
+#define PLUGINS_WINDOW_SIZE_LINUX_WINDOW_POOL_H_
+
+// A process-wide pool of hidden, realized secondary windows, made by the
+// runner's WindowSizeWindowFactory.
+//
+// The pool is refilled from low priority idle sources, one window at a time,
+// so that creating engines doesn't hold up input or drawing. Pooled windows
+// are detached from their GtkApplication, so that they don't keep it running
+// or show up in its window list. If no window is checked out for the idle
+// timeout, the pool is emptied until the next checkout.
+
+#include <gtk/gtk.h>
+
+#include "include/window_size/window_size_plugin.h"
+
+G_BEGIN_DECLS
+
+// Replaces the factory, emptying the pool.
+void window_pool_set_factory(WindowSizeWindowFactory factory,
+                             gpointer user_data,
+                             GDestroyNotify destroy_notify);
+
+// Returns TRUE if a factory has been set.
+gboolean window_pool_has_factory();
+
+// Sets the number of windows to keep ready, and how long the pool may go
+// without a checkout before it is emptied; 0 to never empty it.
+void window_pool_configure(guint size, guint idle_timeout_ms);
+
+// Gets the number of windows ready to be checked out.
+guint window_pool_get_available();
+
+// Takes a window from the pool, creating one if the pool is empty, and
+// reattaches it to its application. The window is realized but not shown.
+// Returns a new reference, or nullptr if there is no factory or it failed.
+GtkWindow* window_pool_checkout();
+
+G_END_DECLS
+
+#endif  // PLUGINS_WINDOW_SIZE_LINUX_WINDOW_POOL_H_
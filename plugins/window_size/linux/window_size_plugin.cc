@@ -16,12 +16,26 @@
 #include <flutter_linux/flutter_linux.h>
 #include <gtk/gtk.h>
 
+#ifdef WINDOW_SIZE_HAVE_XRANDR
+#include <X11/Xatom.h>
+#include <X11/extensions/Xrandr.h>
+#include <gdk/gdkx.h>
+#endif
+
+#include <cmath>
 #include <cstring>
 
+#include "async_method_call.h"
+#include "include/window_size/display_snapshot.h"
+#include "virtual_display.h"
+#include "window_pool.h"
+#include "window_size_snapshot.h"
+
 // See window_size_channel.dart for documentation.
 const char kChannelName[] = "flutter/windowsize";
 const char kBadArgumentsError[] = "Bad Arguments";
 const char kNoScreenError[] = "No Screen";
+const char kNoWindowFactoryError[] = "No Window Factory";
 const char kGetScreenListMethod[] = "getScreenList";
 const char kGetWindowInfoMethod[] = "getWindowInfo";
 const char kSetWindowFrameMethod[] = "setWindowFrame";
@@ -31,10 +45,208 @@ const char kSetWindowTitleMethod[] = "setWindowTitle";
 const char ksetWindowVisibilityMethod[] = "setWindowVisibility";
 const char kGetWindowMinimumSizeMethod[] = "getWindowMinimumSize";
 const char kGetWindowMaximumSizeMethod[] = "getWindowMaximumSize";
+const char kClassifyRectsMethod[] = "classifyRects";
+const char kGetWindowListMethod[] = "getWindowList";
+const char kSetWindowGroupLayoutMethod[] = "setWindowGroupLayout";
+const char kSetWindowParkedMethod[] = "setWindowParked";
+const char kIsWindowParkedMethod[] = "isWindowParked";
+const char kGetResizeSyncStatsMethod[] = "getResizeSyncStats";
+const char kStartPointerTrackingMethod[] = "startPointerTracking";
+const char kStopPointerTrackingMethod[] = "stopPointerTracking";
+const char kPointerPositionChangedCallbackMethod[] = "pointerPositionChanged";
+const char kSetWindowIconMethod[] = "setWindowIcon";
+const char kConvertCoordinatesMethod[] = "convertCoordinates";
+const char kScaleFactorChangedCallbackMethod[] = "scaleFactorChanged";
+const char kSetWindowSnappingMethod[] = "setWindowSnapping";
+const char kSetWindowFullscreenMethod[] = "setWindowFullscreen";
+const char kSetLifecycleSignalsMethod[] = "setLifecycleSignals";
+const char kConfigureWindowPoolMethod[] = "configureWindowPool";
+const char kCreateWindowMethod[] = "createWindow";
+const char kTransformPointsMethod[] = "transformPoints";
 const char kFrameKey[] = "frame";
 const char kVisibleFrameKey[] = "visibleFrame";
 const char kScaleFactorKey[] = "scaleFactor";
+const char kTextScaleFactorKey[] = "textScaleFactor";
 const char kScreenKey[] = "screen";
+const char kFrameExtentsKey[] = "frameExtents";
+const char kShadowExtentsKey[] = "shadowExtents";
+const char kScreensKey[] = "screens";
+const char kOverlapsKey[] = "overlaps";
+const char kWindowIdKey[] = "windowId";
+const char kArgumentsKey[] = "arguments";
+const char kWindowIdsKey[] = "windowIds";
+const char kLayoutKey[] = "layout";
+const char kScreenIndexKey[] = "screenIndex";
+const char kCountKey[] = "count";
+const char kTimeoutsKey[] = "timeouts";
+const char kLastLatencyKey[] = "lastLatency";
+const char kAverageLatencyKey[] = "averageLatency";
+const char kMaxLatencyKey[] = "maxLatency";
+const char kDataKey[] = "data";
+const char kWidthKey[] = "width";
+const char kHeightKey[] = "height";
+const char kPointsKey[] = "points";
+const char kToPhysicalKey[] = "toPhysical";
+const char kOldScaleFactorKey[] = "oldScaleFactor";
+const char kEnabledKey[] = "enabled";
+const char kThresholdKey[] = "threshold";
+const char kFullscreenKey[] = "fullscreen";
+const char kBypassCompositorKey[] = "bypassCompositor";
+const char kMemoryPressureDelayKey[] = "memoryPressureDelay";
+const char kSizeKey[] = "size";
+const char kIdleTimeoutKey[] = "idleTimeout";
+const char kVisibleKey[] = "visible";
+const char kClampToScreenKey[] = "clampToScreen";
+const char kTileLayout[] = "tile";
+const char kCascadeLayout[] = "cascade";
+const char kStackLayout[] = "stack";
+
+// Engine channels used to send lifecycle signals, and their messages. These
+// match the ones sent by the Flutter embedders.
+const char kLifecycleChannelName[] = "flutter/lifecycle";
+const char kSystemChannelName[] = "flutter/system";
+const char kLifecycleInactive[] = "AppLifecycleState.inactive";
+const char kLifecyclePaused[] = "AppLifecycleState.paused";
+const char kLifecycleResumed[] = "AppLifecycleState.resumed";
+const char kTypeKey[] = "type";
+const char kMemoryPressureType[] = "memoryPressure";
+
+// Distance between successive windows in a cascade layout.
+const gint kCascadeOffset = 32;
+
+// How long to wait for a resized window to be configured and painted before
+// responding to setWindowFrame anyway.
+const guint kResizeSyncTimeoutMs = 500;
+
+// How long to wait for the window manager to apply a fullscreen change before
+// responding to setWindowFullscreen anyway.
+const guint kFullscreenTimeoutMs = 500;
+
+// How long the window stays in the background before memoryPressure is sent,
+// if not specified.
+const gint kDefaultMemoryPressureDelayMs = 10000;
+
+// Maximum number of window icons kept in the icon cache.
+const guint kIconCacheSize = 16;
+
+// Margin beyond the top left of the screen where parked windows are moved
+// when they can't be made transparent.
+const gint kParkedOffset = 100;
+
+// How long a moving window must go without being reconfigured before it is
+// snapped, see snap_window().
+const guint kSnapSettleMs = 100;
+
+// Distance within which a moving window snaps to an edge, if not specified.
+const double kDefaultSnapThreshold = 16;
+
+// Font resolution at a scale factor of 1.
+const double kDefaultDpi = 96.0;
+
+// Key used to attach a WindowState to its GtkWindow.
+const char kWindowStateDataKey[] = "window-size-state";
+
+// Window id used when a method call doesn't specify one, meaning the window
+// containing the plugin's view.
+const gint64 kDefaultWindowId = 0;
+
+// State tracked for each window controlled by the plugin. Owned by
+// window_states, and removed automatically when the window is destroyed.
+typedef struct {
+  // Identifier used to address this window over the channel.
+  gint64 id;
+
+  // The window; a weak reference.
+  GtkWindow* window;
+
+  // Requested window geometry.
+  GdkGeometry geometry;
+
+  // TRUE if the window is parked, see park_window().
+  gboolean parked;
+
+  // TRUE if the window was moved off-screen when parked, in which case
+  // parked_x and parked_y are where it came from.
+  gboolean parked_off_screen;
+  gint parked_x;
+  gint parked_y;
+
+  // The setWindowFrame call waiting for its resize to be configured and
+  // painted, see start_resize_sync().
+  FlMethodCall* resize_call;
+  gint64 resize_start_time;
+  gint resize_from_width;
+  gint resize_from_height;
+  gboolean resize_configured;
+  GdkFrameClock* resize_frame_clock;
+  gulong resize_after_paint_handler;
+  guint resize_timeout_source;
+  gulong configure_handler;
+
+  // The icon last set on the window.
+  GdkPixbuf* icon;
+
+  // Cached decoration sizes, see get_frame_extents().
+  gboolean extents_valid;
+  GtkBorder frame_extents;
+  GtkBorder shadow_extents;
+  gulong window_state_handler;
+  gulong property_notify_handler;
+  gulong decorated_handler;
+
+  // TRUE if the window manager has made the window fullscreen.
+  gboolean fullscreen;
+
+  // TRUE if the window asks the compositor to unredirect it, see
+  // set_bypass_compositor().
+  gboolean bypass_compositor;
+
+  // The setWindowFullscreen call waiting for the window manager to apply the
+  // change, see set_window_fullscreen().
+  FlMethodCall* fullscreen_call;
+  gboolean fullscreen_requested;
+  guint fullscreen_timeout_source;
+
+  // Edge snapping while the window is moved, see snap_window().
+  gboolean snap_enabled;
+  double snap_threshold;
+  gint snap_last_x;
+  gint snap_last_y;
+  gint snap_last_width;
+  gint snap_last_height;
+  guint snap_timeout_source;
+
+  // Statistics for resize synchronization, in microseconds.
+  gint64 resize_sync_count;
+  gint64 resize_sync_timeouts;
+  gint64 resize_sync_last_latency;
+  gint64 resize_sync_total_latency;
+  gint64 resize_sync_max_latency;
+} WindowState;
+
+// Window states by id, shared by all plugin instances so that ids are unique
+// across the engines in this process.
+static GHashTable* window_states = nullptr;
+
+// The id to assign to the next window seen.
+static gint64 next_window_id = 1;
+
+// Monitor geometry, cached so that repeated queries don't need to go back to
+// GDK. Edges are stored in separate arrays so that intersection tests against
+// many rects at once can be vectorized.
+typedef struct {
+  // FALSE if the monitor configuration has changed since the cache was built.
+  gboolean valid;
+
+  gint n_monitors;
+  double* left;
+  double* top;
+  double* right;
+  double* bottom;
+
+  // Scale factor of each monitor.
+  double* scale;
+} MonitorCache;
 
 struct _FlWindowSizePlugin {
   GObject parent_instance;
@@ -44,90 +256,1977 @@ struct _FlWindowSizePlugin {
   // Connection to Flutter engine.
   FlMethodChannel* channel;
 
-  // Requested window geometry.
-  GdkGeometry window_geometry;
+  // Method calls being responded to asynchronously.
+  AsyncMethodQueue* async_calls;
+
+  // Display model used in place of GDK when there is no view, see
+  // get_virtual_display().
+  VirtualDisplay* virtual_display;
+
+  // Id of the window containing the view, or kDefaultWindowId if not yet
+  // known.
+  gint64 window_id;
+
+  // Display whose monitor changes are being tracked by monitor_cache.
+  GdkDisplay* monitor_cache_display;
+
+  // Cached monitor geometry for monitor_cache_display.
+  MonitorCache monitor_cache;
+
+  // Idle source that rebuilds monitor_cache after a change.
+  guint monitor_refresh_source;
+
+  // Window icons by content hash, see get_icon().
+  GHashTable* icon_cache;
+
+  // Hashes of the icons in icon_cache, least recently used first.
+  GQueue icon_cache_order;
+
+  // Number of active pointer tracking subscriptions.
+  gint pointer_subscriptions;
+
+  // Frame clock driving pointer tracking while there are subscriptions.
+  GdkFrameClock* pointer_frame_clock;
+  gulong pointer_update_handler;
+
+  // Last pointer position sent to Flutter.
+  gboolean pointer_position_sent;
+  gdouble pointer_x;
+  gdouble pointer_y;
+
+  // Scale factor of the window containing the view, as last seen by
+  // check_scale_factor().
+  gboolean scale_factor_known;
+  gint scale_factor;
+
+  // Lifecycle signals sent to the engine as the window containing the view is
+  // hidden and shown, see update_lifecycle().
+  gboolean lifecycle_enabled;
+  gint memory_pressure_delay;
+  FlBasicMessageChannel* lifecycle_channel;
+  FlBasicMessageChannel* system_channel;
+
+  // The window whose state is tracked; a weak reference.
+  GtkWindow* lifecycle_window;
+  gulong lifecycle_state_handler;
+  gulong lifecycle_hide_handler;
+  gulong lifecycle_show_handler;
+
+  // TRUE if the engine has been told the app is paused.
+  gboolean lifecycle_paused;
+
+  // Timeout that sends memoryPressure while paused.
+  guint memory_pressure_source;
 };
 
 G_DEFINE_TYPE(FlWindowSizePlugin, fl_window_size_plugin, g_object_get_type())
 
-// Gets the window being controlled.
-GtkWindow* get_window(FlWindowSizePlugin* self) {
-  FlView* view = fl_plugin_registrar_get_view(self->registrar);
-  if (view == nullptr) return nullptr;
+// Returns the response used when the target window is unavailable.
+static FlMethodResponse* no_window_response() {
+  return FL_METHOD_RESPONSE(
+      fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
+}
+
+// Completes a resize started by start_resize_sync(), responding to the
+// setWindowFrame call that requested it. |painted| is TRUE if the window was
+// configured and painted at its new size, and FALSE if the wait was cut short.
+static void finish_resize_sync(WindowState* state, FlMethodResponse* response,
+                               gboolean painted) {
+  if (state->resize_call == nullptr) return;
+
+  if (state->resize_after_paint_handler != 0) {
+    g_signal_handler_disconnect(state->resize_frame_clock,
+                                state->resize_after_paint_handler);
+    state->resize_after_paint_handler = 0;
+  }
+  g_clear_object(&state->resize_frame_clock);
+  g_clear_handle_id(&state->resize_timeout_source, g_source_remove);
+
+  if (painted) {
+    gint64 latency = g_get_monotonic_time() - state->resize_start_time;
+    state->resize_sync_count++;
+    state->resize_sync_last_latency = latency;
+    state->resize_sync_total_latency += latency;
+    state->resize_sync_max_latency =
+        MAX(state->resize_sync_max_latency, latency);
+  } else {
+    state->resize_sync_timeouts++;
+  }
+
+  g_autoptr(FlMethodCall) method_call = state->resize_call;
+  state->resize_call = nullptr;
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error))
+    g_warning("Failed to send method call response: %s", error->message);
+}
+
+// Gets the text scale factor of |screen|, rounded to hundredths.
+//
+// GDK only supports integer scale factors, so fractional scales such as 1.25
+// or 1.5 are set up by scaling the font resolution (Xft.dpi on X11) instead.
+// This only affects text: window and screen coordinates are still in units of
+// GDK's integer scale factor. GDK has already divided gtk-xft-dpi by that
+// scale factor, so this is relative to it.
+static double get_text_scale_factor(GdkScreen* screen) {
+  GtkSettings* settings = gtk_settings_get_for_screen(screen);
+  gint xft_dpi = -1;
+  if (settings != nullptr) {
+    g_object_get(settings, "gtk-xft-dpi", &xft_dpi, nullptr);
+  }
+  // gtk-xft-dpi is in 1024ths of a dot per inch, or -1 for the default.
+  if (xft_dpi <= 0) return 1.0;
+  double scale = (xft_dpi / 1024.0) / kDefaultDpi;
+  return round(scale * 100) / 100;
+}
+
+// Gets the index of the monitor showing |window|, or the primary monitor if
+// the window isn't showing.
+static gint get_window_monitor_index(GtkWindow* window) {
+  GdkDisplay* display = gtk_widget_get_display(GTK_WIDGET(window));
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(window));
+  GdkMonitor* monitor =
+      gdk_window != nullptr
+          ? gdk_display_get_monitor_at_window(display, gdk_window)
+          : gdk_display_get_primary_monitor(display);
+
+  gint n_monitors = gdk_display_get_n_monitors(display);
+  for (gint i = 0; i < n_monitors; i++) {
+    if (gdk_display_get_monitor(display, i) == monitor) return i;
+  }
+  return 0;
+}
+
+static void get_frame_extents(WindowState* state, GtkBorder* frame_extents,
+                              GtkBorder* shadow_extents);
+
+// Gets the frame of |state|'s window as seen on screen: including the window
+// manager's decorations, and excluding the shadow drawn by client-side
+// decorations.
+//
+// This uses GDK's position and size of the window's surface from the last
+// configure event, so makes no requests to the display server once the
+// decoration sizes are cached.
+static void get_window_visible_frame(WindowState* state, GdkRectangle* frame) {
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(state->window));
+  if (gdk_window == nullptr) {
+    // Not realized, so there are no decorations yet.
+    gtk_window_get_position(state->window, &frame->x, &frame->y);
+    gtk_window_get_size(state->window, &frame->width, &frame->height);
+    return;
+  }
+
+  GtkBorder frame_extents, shadow_extents;
+  get_frame_extents(state, &frame_extents, &shadow_extents);
+  gdk_window_get_position(gdk_window, &frame->x, &frame->y);
+  frame->x += shadow_extents.left - frame_extents.left;
+  frame->y += shadow_extents.top - frame_extents.top;
+  frame->width = gdk_window_get_width(gdk_window) + frame_extents.left +
+                 frame_extents.right - shadow_extents.left -
+                 shadow_extents.right;
+  frame->height = gdk_window_get_height(gdk_window) + frame_extents.top +
+                  frame_extents.bottom - shadow_extents.top -
+                  shadow_extents.bottom;
+}
+
+// Publishes the window's geometry for window_size_ffi.h. All windows are
+// published with get_window_visible_frame(), so frames can be compared with
+// each other, such as by find_snap().
+static void publish_window_snapshot(WindowState* state) {
+  GdkRectangle visible_frame;
+  get_window_visible_frame(state, &visible_frame);
+  WindowSizeRect frame = {static_cast<double>(visible_frame.x),
+                          static_cast<double>(visible_frame.y),
+                          static_cast<double>(visible_frame.width),
+                          static_cast<double>(visible_frame.height)};
+  gint scale_factor = gtk_widget_get_scale_factor(GTK_WIDGET(state->window));
+  window_size_snapshot_set_window(state->id, &frame, scale_factor,
+                                  get_window_monitor_index(state->window));
+}
+
+// Updates |best| if moving |edge| to |target| is a smaller adjustment than
+// |best|, and within |threshold|.
+static void consider_snap(double edge, double target, double threshold,
+                          double* best) {
+  double adjustment = target - edge;
+  if (fabs(adjustment) <= threshold && fabs(adjustment) < fabs(*best)) {
+    *best = adjustment;
+  }
+}
+
+// Computes how far to move a window at |frame| so that its edges line up with
+// nearby snap targets: the work area edges of each monitor, and the edges of
+// the application's other windows. Returns FALSE if nothing is within the
+// window's snap threshold.
+//
+// Targets come from the display snapshot, so this makes no requests to the
+// display server.
+static gboolean find_snap(WindowState* state, const GdkRectangle* frame,
+                          double* dx, double* dy) {
+  const double t = state->snap_threshold;
+  const double left = frame->x;
+  const double top = frame->y;
+  const double right = left + frame->width;
+  const double bottom = top + frame->height;
+  double best_x = G_MAXDOUBLE;
+  double best_y = G_MAXDOUBLE;
+
+  const WindowSizeDisplaySnapshot* snapshot =
+      window_size_display_snapshot_acquire();
+  for (gint i = 0; i < snapshot->n_monitors; i++) {
+    const WindowSizeRect* area = &snapshot->monitors[i].visible_frame;
+    consider_snap(left, area->x, t, &best_x);
+    consider_snap(right, area->x + area->width, t, &best_x);
+    consider_snap(top, area->y, t, &best_y);
+    consider_snap(bottom, area->y + area->height, t, &best_y);
+  }
+  for (gint i = 0; i < snapshot->n_windows; i++) {
+    const WindowSizeWindowSnapshot* window = &snapshot->windows[i];
+    if (window->id == state->id) continue;
+    const double other_left = window->frame.x;
+    const double other_top = window->frame.y;
+    const double other_right = other_left + window->frame.width;
+    const double other_bottom = other_top + window->frame.height;
+
+    // Dock against or align with the sides of windows alongside.
+    if (top < other_bottom + t && bottom > other_top - t) {
+      consider_snap(left, other_right, t, &best_x);
+      consider_snap(right, other_left, t, &best_x);
+      consider_snap(left, other_left, t, &best_x);
+      consider_snap(right, other_right, t, &best_x);
+    }
+    if (left < other_right + t && right > other_left - t) {
+      consider_snap(top, other_bottom, t, &best_y);
+      consider_snap(bottom, other_top, t, &best_y);
+      consider_snap(top, other_top, t, &best_y);
+      consider_snap(bottom, other_bottom, t, &best_y);
+    }
+  }
+  window_size_display_snapshot_release(snapshot);
+
+  *dx = best_x == G_MAXDOUBLE ? 0 : best_x;
+  *dy = best_y == G_MAXDOUBLE ? 0 : best_y;
+  return *dx != 0 || *dy != 0;
+}
+
+// Called once a window being moved has settled, to snap it to nearby edges.
+static gboolean snap_timeout_cb(gpointer user_data) {
+  WindowState* state = static_cast<WindowState*>(user_data);
+  GdkWindow* gdk_window = state->window != nullptr
+                              ? gtk_widget_get_window(GTK_WIDGET(state->window))
+                              : nullptr;
+  if (gdk_window == nullptr || state->parked || state->resize_call != nullptr) {
+    state->snap_timeout_source = 0;
+    return G_SOURCE_REMOVE;
+  }
+
+  // The window manager is still moving the window while a button is held,
+  // even if the pointer has stopped.
+  GdkDevice* pointer = gdk_seat_get_pointer(
+      gdk_display_get_default_seat(gdk_window_get_display(gdk_window)));
+  GdkModifierType mask = static_cast<GdkModifierType>(0);
+  gdk_window_get_device_position(gdk_window, pointer, nullptr, nullptr, &mask);
+  if (mask & (GDK_BUTTON1_MASK | GDK_BUTTON2_MASK | GDK_BUTTON3_MASK)) {
+    return G_SOURCE_CONTINUE;
+  }
+  state->snap_timeout_source = 0;
+
+  // Snap the frame as seen on screen, in the same terms as the other
+  // windows' frames in the display snapshot.
+  GdkRectangle frame;
+  get_window_visible_frame(state, &frame);
+
+  double dx, dy;
+  if (find_snap(state, &frame, &dx, &dy)) {
+    gint x, y;
+    gtk_window_get_position(state->window, &x, &y);
+    gtk_window_move(state->window, x + round(dx), y + round(dy));
+  }
+  return G_SOURCE_REMOVE;
+}
+
+// Snaps a window being moved to nearby edges once it stops moving.
+//
+// Called for each configure event. Moving the window while the window manager
+// is still moving it would fight the move, so the snap is deferred until the
+// window has gone kSnapSettleMs without moving and no button is held. This
+// needs no round trip to Flutter. Only moves are snapped; resizes, and
+// changes made by the plugin such as setWindowFrame, are left alone.
+static void snap_window(WindowState* state, GdkEventConfigure* event) {
+  gboolean moved =
+      event->width == state->snap_last_width &&
+      event->height == state->snap_last_height &&
+      (event->x != state->snap_last_x || event->y != state->snap_last_y);
+  state->snap_last_x = event->x;
+  state->snap_last_y = event->y;
+  state->snap_last_width = event->width;
+  state->snap_last_height = event->height;
+  if (!moved || state->parked || state->resize_call != nullptr) return;
+
+  g_clear_handle_id(&state->snap_timeout_source, g_source_remove);
+  state->snap_timeout_source =
+      g_timeout_add(kSnapSettleMs, snap_timeout_cb, state);
+}
+
+// Called when a window is reconfigured by the window manager, after GTK has
+// processed the change.
+static gboolean window_configure_cb(GtkWidget* widget, GdkEventConfigure* event,
+                                    WindowState* state) {
+  publish_window_snapshot(state);
+  if (state->snap_enabled) snap_window(state, event);
+
+  if (state->resize_call != nullptr &&
+      (event->width != state->resize_from_width ||
+       event->height != state->resize_from_height)) {
+    state->resize_configured = TRUE;
+  }
+
+  return FALSE;
+}
+
+// Called after the window has painted a frame.
+static void resize_after_paint_cb(GdkFrameClock* frame_clock,
+                                  WindowState* state) {
+  // This is GTK's paint of the window after the window manager applied the
+  // new size. The engine rasterizes on its own thread, so the view may still
+  // be showing its previous frame, stretched, at this point.
+  if (state->resize_configured) {
+    g_autoptr(FlMethodResponse) response =
+        FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+    finish_resize_sync(state, response, TRUE);
+  }
+}
+
+// Called if a resized window isn't configured and painted in time.
+static gboolean resize_timeout_cb(gpointer user_data) {
+  WindowState* state = static_cast<WindowState*>(user_data);
+  state->resize_timeout_source = 0;
+
+  g_autoptr(FlMethodResponse) response =
+      FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  finish_resize_sync(state, response, FALSE);
+
+  return G_SOURCE_REMOVE;
+}
+
+// Defers the response to |method_call| until the window manager has applied
+// the new size and GTK has painted the window since. Must be called before
+// the resize is requested. Returns FALSE if the window isn't being shown, in
+// which case there is nothing to wait for.
+static gboolean start_resize_sync(WindowState* state,
+                                  FlMethodCall* method_call) {
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(state->window));
+  if (gdk_window == nullptr ||
+      !gtk_widget_get_mapped(GTK_WIDGET(state->window))) {
+    return FALSE;
+  }
+
+  // Only the latest request is tracked; earlier ones are complete as far as
+  // the caller is concerned.
+  g_autoptr(FlMethodResponse) response =
+      FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  finish_resize_sync(state, response, FALSE);
+
+  state->resize_call = FL_METHOD_CALL(g_object_ref(method_call));
+  state->resize_start_time = g_get_monotonic_time();
+  state->resize_from_width = gdk_window_get_width(gdk_window);
+  state->resize_from_height = gdk_window_get_height(gdk_window);
+  state->resize_configured = FALSE;
+  state->resize_frame_clock =
+      GDK_FRAME_CLOCK(g_object_ref(gdk_window_get_frame_clock(gdk_window)));
+  state->resize_after_paint_handler =
+      g_signal_connect(state->resize_frame_clock, "after-paint",
+                       G_CALLBACK(resize_after_paint_cb), state);
+  state->resize_timeout_source =
+      g_timeout_add(kResizeSyncTimeoutMs, resize_timeout_cb, state);
+
+  return TRUE;
+}
+
+// Creates the response to setWindowFullscreen, describing the window's
+// current state.
+static FlMethodResponse* make_fullscreen_response(WindowState* state) {
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, kFullscreenKey,
+                           fl_value_new_bool(state->fullscreen));
+  fl_value_set_string_take(
+      result, kBypassCompositorKey,
+      fl_value_new_bool(state->fullscreen && state->bypass_compositor));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Responds to the setWindowFullscreen call waiting for the window manager, if
+// any.
+static void finish_fullscreen(WindowState* state,
+                              FlMethodResponse* response) {
+  if (state->fullscreen_call == nullptr) return;
+
+  g_clear_handle_id(&state->fullscreen_timeout_source, g_source_remove);
+
+  g_autoptr(FlMethodCall) method_call = state->fullscreen_call;
+  state->fullscreen_call = nullptr;
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error))
+    g_warning("Failed to send method call response: %s", error->message);
+}
+
+// Called if the window manager doesn't apply a fullscreen change in time.
+static gboolean fullscreen_timeout_cb(gpointer user_data) {
+  WindowState* state = static_cast<WindowState*>(user_data);
+  state->fullscreen_timeout_source = 0;
+
+  g_autoptr(FlMethodResponse) response = make_fullscreen_response(state);
+  finish_fullscreen(state, response);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void window_state_free(WindowState* state) {
+  if (state->resize_call != nullptr) {
+    g_autoptr(FlMethodResponse) response = no_window_response();
+    finish_resize_sync(state, response, FALSE);
+  }
+  if (state->fullscreen_call != nullptr) {
+    g_autoptr(FlMethodResponse) response = no_window_response();
+    finish_fullscreen(state, response);
+  }
+
+  g_clear_handle_id(&state->snap_timeout_source, g_source_remove);
+  g_clear_object(&state->icon);
+
+  if (state->window != nullptr) {
+    if (state->configure_handler != 0) {
+      g_signal_handler_disconnect(state->window, state->configure_handler);
+    }
+    g_signal_handler_disconnect(state->window, state->window_state_handler);
+    g_signal_handler_disconnect(state->window, state->property_notify_handler);
+    g_signal_handler_disconnect(state->window, state->decorated_handler);
+    g_object_remove_weak_pointer(G_OBJECT(state->window),
+                                 reinterpret_cast<gpointer*>(&state->window));
+  }
+  g_free(state);
+}
+
+// Called when a window is maximized, tiled, made fullscreen etc, which changes
+// its decorations.
+static gboolean window_state_event_cb(GtkWidget* widget,
+                                      GdkEventWindowState* event,
+                                      WindowState* state) {
+  state->extents_valid = FALSE;
+
+  if (event->changed_mask & GDK_WINDOW_STATE_FULLSCREEN) {
+    state->fullscreen =
+        (event->new_window_state & GDK_WINDOW_STATE_FULLSCREEN) != 0;
+    if (state->fullscreen == state->fullscreen_requested) {
+      g_autoptr(FlMethodResponse) response = make_fullscreen_response(state);
+      finish_fullscreen(state, response);
+    }
+  }
+
+  return FALSE;
+}
+
+// Called when a property of a window changes.
+static gboolean window_property_notify_cb(GtkWidget* widget,
+                                          GdkEventProperty* event,
+                                          WindowState* state) {
+  if (event->atom == gdk_atom_intern_static_string("_NET_FRAME_EXTENTS") ||
+      event->atom == gdk_atom_intern_static_string("_GTK_FRAME_EXTENTS")) {
+    state->extents_valid = FALSE;
+  }
+  return FALSE;
+}
+
+// Called when a window's decorations are enabled or disabled.
+static void window_decorated_cb(GObject* object, GParamSpec* pspec,
+                                WindowState* state) {
+  state->extents_valid = FALSE;
+}
+
+// Called when a window with state is destroyed.
+static void window_destroy_cb(GtkWindow* window, WindowState* state) {
+  window_size_snapshot_remove_window(state->id);
+  g_object_set_data(G_OBJECT(window), kWindowStateDataKey, nullptr);
+  g_hash_table_remove(window_states, &state->id);
+}
+
+// Gets the state for |window|, creating it if this is the first time the
+// window has been seen.
+static WindowState* get_state_for_window(GtkWindow* window) {
+  WindowState* state = static_cast<WindowState*>(
+      g_object_get_data(G_OBJECT(window), kWindowStateDataKey));
+  if (state != nullptr) return state;
+
+  if (window_states == nullptr) {
+    window_states = g_hash_table_new_full(
+        g_int64_hash, g_int64_equal, nullptr,
+        reinterpret_cast<GDestroyNotify>(window_state_free));
+  }
+
+  state = g_new0(WindowState, 1);
+  state->id = next_window_id++;
+  state->window = window;
+  g_object_add_weak_pointer(G_OBJECT(window),
+                            reinterpret_cast<gpointer*>(&state->window));
+  state->geometry.min_width = -1;
+  state->geometry.min_height = -1;
+  state->geometry.max_width = G_MAXINT;
+  state->geometry.max_height = G_MAXINT;
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(window));
+  state->fullscreen =
+      gdk_window != nullptr &&
+      (gdk_window_get_state(gdk_window) & GDK_WINDOW_STATE_FULLSCREEN) != 0;
+
+  g_hash_table_insert(window_states, &state->id, state);
+  g_object_set_data(G_OBJECT(window), kWindowStateDataKey, state);
+  g_signal_connect(window, "destroy", G_CALLBACK(window_destroy_cb), state);
+  state->configure_handler =
+      g_signal_connect_after(window, "configure-event",
+                             G_CALLBACK(window_configure_cb), state);
+  state->window_state_handler =
+      g_signal_connect(window, "window-state-event",
+                       G_CALLBACK(window_state_event_cb), state);
+  gtk_widget_add_events(GTK_WIDGET(window), GDK_PROPERTY_CHANGE_MASK);
+  state->property_notify_handler =
+      g_signal_connect(window, "property-notify-event",
+                       G_CALLBACK(window_property_notify_cb), state);
+  state->decorated_handler = g_signal_connect(
+      window, "notify::decorated", G_CALLBACK(window_decorated_cb), state);
+  publish_window_snapshot(state);
+
+  return state;
+}
+
+static void check_scale_factor(FlWindowSizePlugin* self);
+
+// Gets the state for the window with the given id, or nullptr if there is no
+// such window.
+static WindowState* get_window_state(FlWindowSizePlugin* self, gint64 id) {
+  if (id == kDefaultWindowId) {
+    id = self->window_id;
+  }
+
+  if (id != kDefaultWindowId && window_states != nullptr) {
+    WindowState* state =
+        static_cast<WindowState*>(g_hash_table_lookup(window_states, &id));
+    if (state != nullptr || id != self->window_id) return state;
+  }
+
+  // The window containing the view isn't known yet, or has been replaced.
+  if (id != self->window_id) return nullptr;
+  FlView* view = fl_plugin_registrar_get_view(self->registrar);
+  if (view == nullptr) return nullptr;
+  GtkWidget* toplevel = gtk_widget_get_toplevel(GTK_WIDGET(view));
+  if (!gtk_widget_is_toplevel(toplevel)) return nullptr;
+
+  WindowState* state = get_state_for_window(GTK_WINDOW(toplevel));
+  self->window_id = state->id;
+  window_size_snapshot_set_default_window(state->id);
+  g_signal_connect_object(toplevel, "notify::scale-factor",
+                          G_CALLBACK(check_scale_factor), self,
+                          G_CONNECT_SWAPPED);
+  return state;
+}
+
+// Sends scaleFactorChanged to Flutter if the scale factor of the
+// window containing the view has changed since it was last checked.
+static void check_scale_factor(FlWindowSizePlugin* self) {
+  WindowState* state = get_window_state(self, kDefaultWindowId);
+  if (state == nullptr) return;
+
+  gint scale_factor = gtk_widget_get_scale_factor(GTK_WIDGET(state->window));
+  if (!self->scale_factor_known) {
+    self->scale_factor_known = TRUE;
+    self->scale_factor = scale_factor;
+    return;
+  }
+  if (scale_factor == self->scale_factor) return;
+
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string_take(value, kWindowIdKey, fl_value_new_int(state->id));
+  fl_value_set_string_take(value, kOldScaleFactorKey,
+                           fl_value_new_float(self->scale_factor));
+  fl_value_set_string_take(value, kScaleFactorKey,
+                           fl_value_new_float(scale_factor));
+  fl_value_set_string_take(
+      value, kScreenIndexKey,
+      fl_value_new_int(get_window_monitor_index(state->window)));
+  self->scale_factor = scale_factor;
+
+  publish_window_snapshot(state);
+  fl_method_channel_invoke_method(self->channel,
+                                  kScaleFactorChangedCallbackMethod, value,
+                                  nullptr, nullptr, nullptr);
+}
+
+// Gets the display connection.
+GdkDisplay* get_display(FlWindowSizePlugin* self) {
+  FlView* view = fl_plugin_registrar_get_view(self->registrar);
+  if (view == nullptr) return nullptr;
+
+  return gtk_widget_get_display(GTK_WIDGET(view));
+}
+
+// Converts frame dimensions into the Flutter representation.
+FlValue* make_frame_value(gint x, gint y, gint width, gint height) {
+  g_autoptr(FlValue) value = fl_value_new_list();
+
+  fl_value_append_take(value, fl_value_new_float(x));
+  fl_value_append_take(value, fl_value_new_float(y));
+  fl_value_append_take(value, fl_value_new_float(width));
+  fl_value_append_take(value, fl_value_new_float(height));
+
+  return fl_value_ref(value);
+}
+
+// Converts monitor information into the Flutter representation.
+FlValue* make_monitor_value(GdkMonitor* monitor) {
+  g_autoptr(FlValue) value = fl_value_new_map();
+
+  GdkRectangle frame;
+  gdk_monitor_get_geometry(monitor, &frame);
+  fl_value_set_string_take(
+      value, kFrameKey,
+      make_frame_value(frame.x, frame.y, frame.width, frame.height));
+
+  gdk_monitor_get_workarea(monitor, &frame);
+  fl_value_set_string_take(
+      value, kVisibleFrameKey,
+      make_frame_value(frame.x, frame.y, frame.width, frame.height));
+
+  gint scale_factor = gdk_monitor_get_scale_factor(monitor);
+  fl_value_set_string_take(value, kScaleFactorKey,
+                           fl_value_new_float(scale_factor));
+  fl_value_set_string_take(
+      value, kTextScaleFactorKey,
+      fl_value_new_float(get_text_scale_factor(
+          gdk_display_get_default_screen(gdk_monitor_get_display(monitor)))));
+
+  return fl_value_ref(value);
+}
+
+// Gets the list of current screens from GDK.
+static FlMethodResponse* get_screen_list_gdk(FlWindowSizePlugin* self) {
+  g_autoptr(FlValue) screens = fl_value_new_list();
+
+  GdkDisplay* display = get_display(self);
+  if (display == nullptr) {
+    return FL_METHOD_RESPONSE(
+        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
+  }
+
+  gint n_monitors = gdk_display_get_n_monitors(display);
+  for (gint i = 0; i < n_monitors; i++) {
+    GdkMonitor* monitor = gdk_display_get_monitor(display, i);
+    fl_value_append_take(screens, make_monitor_value(monitor));
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(screens));
+}
+
+static FlMethodResponse* get_screen_list_gdk_cb(gpointer data,
+                                                GCancellable* cancellable) {
+  return get_screen_list_gdk(FL_WINDOW_SIZE_PLUGIN(data));
+}
+
+#ifdef WINDOW_SIZE_HAVE_XRANDR
+// Connection used by worker threads to query XRandR, so that a slow X server
+// doesn't block the GTK main loop. Guarded by xrandr_lock.
+//
+// Using Xlib from more than one thread needs it to be initialized for
+// threads, which GDK doesn't do; libX11 does it by itself since 1.8, which
+// CMakeLists.txt requires for this path. X errors go to the process-wide
+// handler installed by GDK, which ignores errors on connections it didn't
+// open. The requests made here only read from the root window of a server
+// checked by xrandr_has_monitors(), so aren't expected to fail.
+G_LOCK_DEFINE_STATIC(xrandr_lock);
+static Display* xrandr_display = nullptr;
+static gchar* xrandr_display_name = nullptr;
+
+// The parameters of a screen list query on a worker thread.
+typedef struct {
+  gchar* display_name;
+  // GDK's integer scale factor, which divides X coordinates.
+  gint scale_factor;
+  // See get_text_scale_factor().
+  double text_scale_factor;
+} ScreenListQuery;
+
+static void screen_list_query_free(gpointer data) {
+  ScreenListQuery* query = static_cast<ScreenListQuery*>(data);
+  g_free(query->display_name);
+  g_free(query);
+}
+
+// Gets the work area of the current desktop from _NET_WORKAREA, in X
+// coordinates. Returns FALSE if the window manager doesn't set it.
+static gboolean get_x11_workarea(Display* display, GdkRectangle* workarea) {
+  Window root = DefaultRootWindow(display);
+  Atom type;
+  int format;
+  unsigned long n_items, bytes_after;
+  unsigned char* data = nullptr;
+
+  long desktop = 0;
+  if (XGetWindowProperty(display, root,
+                         XInternAtom(display, "_NET_CURRENT_DESKTOP", False),
+                         0, 1, False, XA_CARDINAL, &type, &format, &n_items,
+                         &bytes_after, &data) == Success &&
+      data != nullptr && format == 32 && n_items == 1) {
+    desktop = reinterpret_cast<long*>(data)[0];
+  }
+  if (data != nullptr) XFree(data);
+
+  data = nullptr;
+  gboolean found = FALSE;
+  if (XGetWindowProperty(display, root,
+                         XInternAtom(display, "_NET_WORKAREA", False),
+                         desktop * 4, 4, False, XA_CARDINAL, &type, &format,
+                         &n_items, &bytes_after, &data) == Success &&
+      data != nullptr && format == 32 && n_items == 4) {
+    long* values = reinterpret_cast<long*>(data);
+    workarea->x = values[0];
+    workarea->y = values[1];
+    workarea->width = values[2];
+    workarea->height = values[3];
+    found = TRUE;
+  }
+  if (data != nullptr) XFree(data);
+  return found;
+}
+
+// Returns TRUE if the X server for |display| supports RandR 1.5, which added
+// the monitors queried by get_screen_list_xrandr_cb(). This makes a round
+// trip, so is only checked for the first display asked about.
+static gboolean xrandr_has_monitors(GdkDisplay* display) {
+  static gint has_monitors = -1;
+  if (has_monitors < 0) {
+    Display* xdisplay = gdk_x11_display_get_xdisplay(display);
+    int event_base, error_base;
+    int major = 0, minor = 0;
+    has_monitors = XRRQueryExtension(xdisplay, &event_base, &error_base) &&
+                   XRRQueryVersion(xdisplay, &major, &minor) &&
+                   (major > 1 || (major == 1 && minor >= 5));
+  }
+  return has_monitors;
+}
+
+// Gets the list of current screens from XRandR, on a worker thread.
+//
+// This matches what GDK reports for X11 displays: monitors in XRandR order,
+// in coordinates divided by the display's scale factor, with the work area
+// applied to the primary monitor only.
+static FlMethodResponse* get_screen_list_xrandr_cb(gpointer data,
+                                                   GCancellable* cancellable) {
+  ScreenListQuery* query = static_cast<ScreenListQuery*>(data);
+  g_autoptr(FlValue) screens = fl_value_new_list();
+
+  G_LOCK(xrandr_lock);
+  if (xrandr_display != nullptr &&
+      g_strcmp0(xrandr_display_name, query->display_name) != 0) {
+    XCloseDisplay(xrandr_display);
+    xrandr_display = nullptr;
+  }
+  if (xrandr_display == nullptr) {
+    xrandr_display = XOpenDisplay(query->display_name);
+    g_free(xrandr_display_name);
+    xrandr_display_name = g_strdup(query->display_name);
+  }
+
+  int n_monitors = 0;
+  XRRMonitorInfo* monitors = nullptr;
+  GdkRectangle workarea;
+  gboolean have_workarea = FALSE;
+  if (xrandr_display != nullptr) {
+    monitors = XRRGetMonitors(xrandr_display,
+                              DefaultRootWindow(xrandr_display), True,
+                              &n_monitors);
+    have_workarea = get_x11_workarea(xrandr_display, &workarea);
+  }
+  G_UNLOCK(xrandr_lock);
+
+  if (monitors == nullptr) {
+    return FL_METHOD_RESPONSE(
+        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
+  }
+
+  gint scale = query->scale_factor;
+  for (int i = 0; i < n_monitors; i++) {
+    GdkRectangle frame = {monitors[i].x, monitors[i].y, monitors[i].width,
+                          monitors[i].height};
+    GdkRectangle visible_frame = frame;
+    if (monitors[i].primary && have_workarea &&
+        !gdk_rectangle_intersect(&frame, &workarea, &visible_frame)) {
+      visible_frame = frame;
+    }
+
+    g_autoptr(FlValue) value = fl_value_new_map();
+    fl_value_set_string_take(
+        value, kFrameKey,
+        make_frame_value(frame.x / scale, frame.y / scale, frame.width / scale,
+                         frame.height / scale));
+    fl_value_set_string_take(
+        value, kVisibleFrameKey,
+        make_frame_value(visible_frame.x / scale, visible_frame.y / scale,
+                         visible_frame.width / scale,
+                         visible_frame.height / scale));
+    fl_value_set_string_take(value, kScaleFactorKey,
+                             fl_value_new_float(scale));
+    fl_value_set_string_take(value, kTextScaleFactorKey,
+                             fl_value_new_float(query->text_scale_factor));
+    fl_value_append(screens, value);
+  }
+  XRRFreeMonitors(monitors);
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(screens));
+}
+#endif
+
+// Gets the list of current screens, responding asynchronously.
+//
+// Monitor queries make a round trip to the display server, which can take a
+// long time on a remote or busy X server. Where possible the query is made on
+// a worker thread with its own X connection, if the X server supports RandR
+// 1.5; otherwise it is deferred so that pending input is handled first.
+static FlMethodResponse* get_screen_list(FlWindowSizePlugin* self,
+                                         FlMethodCall* method_call) {
+  GdkDisplay* display = get_display(self);
+  if (display == nullptr) {
+    return FL_METHOD_RESPONSE(
+        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
+  }
+
+#ifdef WINDOW_SIZE_HAVE_XRANDR
+  if (GDK_IS_X11_DISPLAY(display) && gdk_display_get_n_monitors(display) > 0 &&
+      xrandr_has_monitors(display)) {
+    ScreenListQuery* query = g_new0(ScreenListQuery, 1);
+    query->display_name = g_strdup(gdk_display_get_name(display));
+    query->scale_factor =
+        gdk_monitor_get_scale_factor(gdk_display_get_monitor(display, 0));
+    query->text_scale_factor =
+        get_text_scale_factor(gdk_display_get_default_screen(display));
+    async_method_queue_run_in_thread(self->async_calls, method_call,
+                                     get_screen_list_xrandr_cb, query,
+                                     screen_list_query_free);
+    return nullptr;
+  }
+#endif
+
+  async_method_queue_run_on_main(self->async_calls, method_call,
+                                 get_screen_list_gdk_cb, g_object_ref(self),
+                                 g_object_unref);
+  return nullptr;
+}
+
+static const MonitorCache* get_monitor_cache(FlWindowSizePlugin* self);
+
+// Rebuilds the monitor cache after a configuration change, so the change is
+// published for window_size_ffi.h.
+static gboolean refresh_monitor_cache_cb(gpointer user_data) {
+  FlWindowSizePlugin* self = FL_WINDOW_SIZE_PLUGIN(user_data);
+  self->monitor_refresh_source = 0;
+  get_monitor_cache(self);
+
+  // Monitor scale and font resolution changes affect the window's effective
+  // scale factor.
+  check_scale_factor(self);
+  return G_SOURCE_REMOVE;
+}
+
+// Called when the monitor configuration changes.
+static void monitors_changed_cb(FlWindowSizePlugin* self) {
+  self->monitor_cache.valid = FALSE;
+  if (self->monitor_refresh_source == 0) {
+    self->monitor_refresh_source = g_idle_add_full(
+        G_PRIORITY_DEFAULT_IDLE, refresh_monitor_cache_cb, g_object_ref(self),
+        g_object_unref);
+  }
+}
+
+// Releases the storage held by the monitor cache.
+static void monitor_cache_clear(MonitorCache* cache) {
+  // All edges share a single allocation, see get_monitor_cache().
+  g_clear_pointer(&cache->left, g_free);
+  cache->top = cache->right = cache->bottom = cache->scale = nullptr;
+  cache->n_monitors = 0;
+  cache->valid = FALSE;
+}
+
+// Allocates storage in |cache| for |n_monitors| monitors.
+static void monitor_cache_alloc(MonitorCache* cache, gint n_monitors) {
+  monitor_cache_clear(cache);
+  cache->n_monitors = n_monitors;
+  cache->left = g_new(double, 5 * MAX(n_monitors, 1));
+  cache->top = cache->left + n_monitors;
+  cache->right = cache->top + n_monitors;
+  cache->bottom = cache->right + n_monitors;
+  cache->scale = cache->bottom + n_monitors;
+}
+
+// Publishes the virtual window's geometry for window_size_ffi.h.
+static void publish_virtual_window(VirtualDisplay* display) {
+  gint monitor = virtual_display_get_window_monitor(display);
+  window_size_snapshot_set_window(display->window_id, &display->window_frame,
+                                  display->monitors[monitor].scale_factor,
+                                  monitor);
+}
+
+// Gets the virtual display used when the plugin has no view, creating it the
+// first time it's needed. Returns nullptr if there is a view.
+static VirtualDisplay* get_virtual_display(FlWindowSizePlugin* self) {
+  if (fl_plugin_registrar_get_view(self->registrar) != nullptr) return nullptr;
+  if (self->virtual_display != nullptr) return self->virtual_display;
+
+  VirtualDisplay* display = virtual_display_new();
+  display->window_id = next_window_id++;
+  self->virtual_display = display;
+  self->window_id = display->window_id;
+
+  MonitorCache* cache = &self->monitor_cache;
+  monitor_cache_alloc(cache, display->n_monitors);
+  for (gint i = 0; i < display->n_monitors; i++) {
+    const WindowSizeRect* frame = &display->monitors[i].frame;
+    cache->left[i] = frame->x;
+    cache->top[i] = frame->y;
+    cache->right[i] = frame->x + frame->width;
+    cache->bottom[i] = frame->y + frame->height;
+    cache->scale[i] = display->monitors[i].scale_factor;
+  }
+  cache->valid = TRUE;
+
+  window_size_snapshot_set_monitors(display->monitors, display->n_monitors);
+  publish_virtual_window(display);
+  window_size_snapshot_set_default_window(display->window_id);
+  return display;
+}
+
+// Gets the cached monitor geometry, rebuilding it if the monitor configuration
+// has changed. Returns nullptr if there is no display.
+static const MonitorCache* get_monitor_cache(FlWindowSizePlugin* self) {
+  // Without a view, the virtual display's monitors are cached on creation
+  // and never change.
+  if (get_virtual_display(self) != nullptr) return &self->monitor_cache;
+
+  GdkDisplay* display = get_display(self);
+  if (display == nullptr) return nullptr;
+
+  if (display != self->monitor_cache_display) {
+    if (self->monitor_cache_display != nullptr) {
+      g_signal_handlers_disconnect_by_func(
+          self->monitor_cache_display,
+          reinterpret_cast<gpointer>(monitors_changed_cb), self);
+    }
+    self->monitor_cache_display = display;
+    g_signal_connect_object(display, "monitor-added",
+                            G_CALLBACK(monitors_changed_cb), self,
+                            G_CONNECT_SWAPPED);
+    g_signal_connect_object(display, "monitor-removed",
+                            G_CALLBACK(monitors_changed_cb), self,
+                            G_CONNECT_SWAPPED);
+    self->monitor_cache.valid = FALSE;
+  }
+
+  MonitorCache* cache = &self->monitor_cache;
+  if (cache->valid) return cache;
+
+  gint n_monitors = gdk_display_get_n_monitors(display);
+  monitor_cache_alloc(cache, n_monitors);
+  g_autofree WindowSizeMonitor* snapshot =
+      g_new0(WindowSizeMonitor, MAX(n_monitors, 1));
+  for (gint i = 0; i < n_monitors; i++) {
+    GdkMonitor* monitor = gdk_display_get_monitor(display, i);
+
+    // Monitors that persist across a configuration change keep their handler,
+    // so remove it before connecting again.
+    g_signal_handlers_disconnect_by_func(
+        monitor, reinterpret_cast<gpointer>(monitors_changed_cb), self);
+    g_signal_connect_object(monitor, "notify::geometry",
+                            G_CALLBACK(monitors_changed_cb), self,
+                            G_CONNECT_SWAPPED);
+    g_signal_connect_object(monitor, "notify::workarea",
+                            G_CALLBACK(monitors_changed_cb), self,
+                            G_CONNECT_SWAPPED);
+    g_signal_connect_object(monitor, "notify::scale-factor",
+                            G_CALLBACK(monitors_changed_cb), self,
+                            G_CONNECT_SWAPPED);
+
+    GdkRectangle frame;
+    gdk_monitor_get_geometry(monitor, &frame);
+    cache->left[i] = frame.x;
+    cache->top[i] = frame.y;
+    cache->right[i] = frame.x + frame.width;
+    cache->bottom[i] = frame.y + frame.height;
+    snapshot[i].frame = {static_cast<double>(frame.x),
+                         static_cast<double>(frame.y),
+                         static_cast<double>(frame.width),
+                         static_cast<double>(frame.height)};
+
+    gdk_monitor_get_workarea(monitor, &frame);
+    snapshot[i].visible_frame = {static_cast<double>(frame.x),
+                                 static_cast<double>(frame.y),
+                                 static_cast<double>(frame.width),
+                                 static_cast<double>(frame.height)};
+    cache->scale[i] = gdk_monitor_get_scale_factor(monitor);
+    snapshot[i].scale_factor = cache->scale[i];
+  }
+  cache->valid = TRUE;
+  window_size_snapshot_set_monitors(snapshot, n_monitors);
+
+  return cache;
+}
+
+// Gets the index of the monitor containing a point, or -1 if none does.
+static gint monitor_cache_find(const MonitorCache* cache, double x, double y) {
+  for (gint i = 0; i < cache->n_monitors; i++) {
+    if (x >= cache->left[i] && x < cache->right[i] && y >= cache->top[i] &&
+        y < cache->bottom[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Computes the fraction of each rect that lies on each monitor.
+//
+// |rects| is |n_rects| packed [left, top, width, height] values. On return
+// |overlaps| holds |n_rects| rows of |cache->n_monitors| fractions, and
+// |screens| holds the index of the monitor with the largest overlap for each
+// rect, or -1 if the rect isn't on any monitor.
+static void classify_rects(const MonitorCache* cache, const double* rects,
+                           size_t n_rects, double* overlaps, int32_t* screens) {
+  const gint n_monitors = cache->n_monitors;
+  const double* __restrict__ m_left = cache->left;
+  const double* __restrict__ m_top = cache->top;
+  const double* __restrict__ m_right = cache->right;
+  const double* __restrict__ m_bottom = cache->bottom;
+
+  for (size_t i = 0; i < n_rects; i++) {
+    const double left = rects[i * 4];
+    const double top = rects[i * 4 + 1];
+    const double right = left + rects[i * 4 + 2];
+    const double bottom = top + rects[i * 4 + 3];
+    const double area = (right - left) * (bottom - top);
+    const double inverse_area = area > 0 ? 1.0 / area : 0.0;
+    double* __restrict__ row = overlaps + i * n_monitors;
+
+    // Branch-free so that the compiler can vectorize across monitors.
+    for (gint m = 0; m < n_monitors; m++) {
+      double width = MIN(right, m_right[m]) - MAX(left, m_left[m]);
+      double height = MIN(bottom, m_bottom[m]) - MAX(top, m_top[m]);
+      row[m] = MAX(width, 0.0) * MAX(height, 0.0) * inverse_area;
+    }
+
+    int32_t best = -1;
+    double best_overlap = 0.0;
+    for (gint m = 0; m < n_monitors; m++) {
+      if (row[m] > best_overlap) {
+        best = m;
+        best_overlap = row[m];
+      }
+    }
+    screens[i] = best;
+  }
+}
+
+// Classifies rects by the monitors they overlap.
+static FlMethodResponse* classify_rects(FlWindowSizePlugin* self,
+                                        FlValue* args) {
+  if (fl_value_get_type(args) != FL_VALUE_TYPE_FLOAT_LIST ||
+      fl_value_get_length(args) % 4 != 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected Float64List of packed rects", nullptr));
+  }
+
+  const MonitorCache* cache = get_monitor_cache(self);
+  if (cache == nullptr) {
+    return FL_METHOD_RESPONSE(
+        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
+  }
+
+  size_t n_rects = fl_value_get_length(args) / 4;
+  g_autofree double* overlaps = g_new(double, n_rects * cache->n_monitors);
+  g_autofree int32_t* screens = g_new(int32_t, n_rects);
+  classify_rects(cache, fl_value_get_float_list(args), n_rects, overlaps,
+                 screens);
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, kScreensKey,
+                           fl_value_new_int32_list(screens, n_rects));
+  fl_value_set_string_take(
+      result, kOverlapsKey,
+      fl_value_new_float_list(overlaps, n_rects * cache->n_monitors));
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Converts |n_points| packed [x, y] screen coordinates between logical and
+// physical pixels, using the scale factor of the monitor each point is on.
+// Points not on any monitor use the first monitor's scale factor.
+static void convert_points(const MonitorCache* cache, const double* points,
+                           size_t n_points, gboolean to_physical,
+                           double* result) {
+  const gint n_monitors = cache->n_monitors;
+  const double default_scale = n_monitors > 0 ? cache->scale[0] : 1.0;
+
+  for (size_t i = 0; i < n_points; i++) {
+    const double x = points[i * 2];
+    const double y = points[i * 2 + 1];
+    double scale = default_scale;
+    for (gint m = 0; m < n_monitors; m++) {
+      // Physical points are compared against the monitor's physical bounds.
+      const double s = to_physical ? 1.0 : cache->scale[m];
+      if (x >= cache->left[m] * s && x < cache->right[m] * s &&
+          y >= cache->top[m] * s && y < cache->bottom[m] * s) {
+        scale = cache->scale[m];
+        break;
+      }
+    }
+    const double factor = to_physical ? scale : 1.0 / scale;
+    result[i * 2] = x * factor;
+    result[i * 2 + 1] = y * factor;
+  }
+}
+
+// Converts points between logical and physical pixels.
+static FlMethodResponse* convert_coordinates(FlWindowSizePlugin* self,
+                                             FlValue* args) {
+  FlValue* points_value = nullptr;
+  FlValue* to_physical_value = nullptr;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    points_value = fl_value_lookup_string(args, kPointsKey);
+    to_physical_value = fl_value_lookup_string(args, kToPhysicalKey);
+  }
+  if (points_value == nullptr ||
+      fl_value_get_type(points_value) != FL_VALUE_TYPE_FLOAT_LIST ||
+      fl_value_get_length(points_value) % 2 != 0 ||
+      to_physical_value == nullptr ||
+      fl_value_get_type(to_physical_value) != FL_VALUE_TYPE_BOOL) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError,
+        "Expected map with Float64List of packed points and direction",
+        nullptr));
+  }
+
+  const MonitorCache* cache = get_monitor_cache(self);
+  if (cache == nullptr) {
+    return FL_METHOD_RESPONSE(
+        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
+  }
+
+  size_t length = fl_value_get_length(points_value);
+  g_autofree double* result = g_new(double, MAX(length, 1));
+  convert_points(cache, fl_value_get_float_list(points_value), length / 2,
+                 fl_value_get_bool(to_physical_value), result);
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(
+      fl_value_new_float_list(result, length)));
+}
+
+// Called on each frame while the pointer is being tracked.
+static void pointer_update_cb(GdkFrameClock* frame_clock,
+                              FlWindowSizePlugin* self) {
+  GdkDisplay* display = get_display(self);
+  if (display == nullptr) return;
+  GdkSeat* seat = gdk_display_get_default_seat(display);
+  GdkDevice* pointer = seat != nullptr ? gdk_seat_get_pointer(seat) : nullptr;
+  if (pointer == nullptr) return;
+
+  gdouble x, y;
+  gdk_device_get_position_double(pointer, nullptr, &x, &y);
+  if (self->pointer_position_sent && x == self->pointer_x &&
+      y == self->pointer_y) {
+    return;
+  }
+  self->pointer_position_sent = TRUE;
+  self->pointer_x = x;
+  self->pointer_y = y;
+
+  const MonitorCache* cache = get_monitor_cache(self);
+  gint monitor = cache != nullptr ? monitor_cache_find(cache, x, y) : -1;
+  double position[] = {x, y, static_cast<double>(monitor)};
+  g_autoptr(FlValue) value =
+      fl_value_new_float_list(position, G_N_ELEMENTS(position));
+  fl_method_channel_invoke_method(self->channel,
+                                  kPointerPositionChangedCallbackMethod, value,
+                                  nullptr, nullptr, nullptr);
+}
+
+// Stops sampling the pointer position.
+static void stop_pointer_updates(FlWindowSizePlugin* self) {
+  if (self->pointer_frame_clock == nullptr) return;
+
+  g_signal_handler_disconnect(self->pointer_frame_clock,
+                              self->pointer_update_handler);
+  self->pointer_update_handler = 0;
+  gdk_frame_clock_end_updating(self->pointer_frame_clock);
+  g_clear_object(&self->pointer_frame_clock);
+}
+
+// Adds a pointer tracking subscription, sending the global pointer position
+// to Flutter on each frame that it changes.
+static FlMethodResponse* start_pointer_tracking(FlWindowSizePlugin* self,
+                                               WindowState* state) {
+  if (state == nullptr) return no_window_response();
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(state->window));
+  if (gdk_window == nullptr) return no_window_response();
+
+  self->pointer_subscriptions++;
+  if (self->pointer_frame_clock == nullptr) {
+    self->pointer_frame_clock =
+        GDK_FRAME_CLOCK(g_object_ref(gdk_window_get_frame_clock(gdk_window)));
+    self->pointer_update_handler = g_signal_connect(
+        self->pointer_frame_clock, "update", G_CALLBACK(pointer_update_cb),
+        self);
+    gdk_frame_clock_begin_updating(self->pointer_frame_clock);
+
+    // Always send the position at the start of tracking.
+    self->pointer_position_sent = FALSE;
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+// Removes a pointer tracking subscription.
+static FlMethodResponse* stop_pointer_tracking(FlWindowSizePlugin* self) {
+  if (self->pointer_subscriptions > 0) {
+    self->pointer_subscriptions--;
+    if (self->pointer_subscriptions == 0) stop_pointer_updates(self);
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+// Compares icon hashes, for searching icon_cache_order.
+static gint compare_icon_hash(const guint64* a, const guint64* b) {
+  return *a == *b ? 0 : 1;
+}
+
+// Computes a hash of RGBA icon data.
+static guint64 hash_icon(const uint8_t* data, size_t length, gint width,
+                         gint height) {
+  // 64-bit FNV-1a, seeded with the dimensions.
+  const guint64 prime = G_GUINT64_CONSTANT(1099511628211);
+  guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+  hash = (hash ^ static_cast<guint64>(width)) * prime;
+  hash = (hash ^ static_cast<guint64>(height)) * prime;
+  for (size_t i = 0; i < length; i++) hash = (hash ^ data[i]) * prime;
+  return hash;
+}
+
+// Gets a pixbuf for RGBA icon data in |data_value|, reusing a cached one if
+// the same icon has been seen recently.
+static GdkPixbuf* get_icon(FlWindowSizePlugin* self, FlValue* data_value,
+                           gint width, gint height) {
+  const uint8_t* data = fl_value_get_uint8_list(data_value);
+  size_t length = static_cast<size_t>(width) * height * 4;
+  guint64 hash = hash_icon(data, length, width, height);
+
+  if (self->icon_cache == nullptr) {
+    self->icon_cache = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+                                             g_free, g_object_unref);
+  }
+
+  GdkPixbuf* icon = GDK_PIXBUF(g_hash_table_lookup(self->icon_cache, &hash));
+  if (icon != nullptr) {
+    GList* link = g_queue_find_custom(
+        &self->icon_cache_order, &hash,
+        reinterpret_cast<GCompareFunc>(compare_icon_hash));
+    g_queue_unlink(&self->icon_cache_order, link);
+    if (gdk_pixbuf_get_width(icon) == width &&
+        gdk_pixbuf_get_height(icon) == height &&
+        memcmp(gdk_pixbuf_read_pixels(icon), data, length) == 0) {
+      g_queue_push_tail_link(&self->icon_cache_order, link);
+      return icon;
+    }
+
+    // A different icon with the same hash; replace it.
+    g_list_free(link);
+    g_hash_table_remove(self->icon_cache, &hash);
+  }
+
+  // Wrap the channel's buffer rather than copying it; the pixbuf keeps the
+  // value alive.
+  g_autoptr(GBytes) bytes = g_bytes_new_with_free_func(
+      data, length, reinterpret_cast<GDestroyNotify>(fl_value_unref),
+      fl_value_ref(data_value));
+  icon = gdk_pixbuf_new_from_bytes(bytes, GDK_COLORSPACE_RGB, TRUE, 8, width,
+                                   height, width * 4);
+
+  guint64* key = g_new(guint64, 1);
+  *key = hash;
+  g_hash_table_insert(self->icon_cache, key, icon);
+  g_queue_push_tail(&self->icon_cache_order, key);
+  if (g_queue_get_length(&self->icon_cache_order) > kIconCacheSize) {
+    guint64* oldest =
+        static_cast<guint64*>(g_queue_pop_head(&self->icon_cache_order));
+    g_hash_table_remove(self->icon_cache, oldest);
+  }
+
+  return icon;
+}
+
+// Sets the window icon from RGBA data.
+static FlMethodResponse* set_window_icon(FlWindowSizePlugin* self,
+                                         WindowState* state, FlValue* args) {
+  FlValue* data_value = nullptr;
+  FlValue* width_value = nullptr;
+  FlValue* height_value = nullptr;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    data_value = fl_value_lookup_string(args, kDataKey);
+    width_value = fl_value_lookup_string(args, kWidthKey);
+    height_value = fl_value_lookup_string(args, kHeightKey);
+  }
+  if (data_value == nullptr ||
+      fl_value_get_type(data_value) != FL_VALUE_TYPE_UINT8_LIST ||
+      width_value == nullptr ||
+      fl_value_get_type(width_value) != FL_VALUE_TYPE_INT ||
+      height_value == nullptr ||
+      fl_value_get_type(height_value) != FL_VALUE_TYPE_INT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected map with RGBA data, width and height",
+        nullptr));
+  }
+  int64_t width = fl_value_get_int(width_value);
+  int64_t height = fl_value_get_int(height_value);
+  if (width <= 0 || height <= 0 || width > G_MAXINT / 4 ||
+      static_cast<guint64>(fl_value_get_length(data_value)) <
+          static_cast<guint64>(width) * height * 4) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "RGBA data doesn't match dimensions", nullptr));
+  }
+
+  if (state == nullptr) return no_window_response();
+
+  GdkPixbuf* icon = get_icon(self, data_value, width, height);
+  if (icon != state->icon) {
+    g_set_object(&state->icon, icon);
+    GList* icons = g_list_append(nullptr, icon);
+    gtk_window_set_icon_list(state->window, icons);
+    g_list_free(icons);
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+// Reads a [left, right, top, bottom] CARDINAL property of |window|, as used
+// for _NET_FRAME_EXTENTS and _GTK_FRAME_EXTENTS. Returns FALSE if the
+// property isn't set, e.g. when not running on X11.
+static gboolean get_border_property(GdkWindow* window, const gchar* name,
+                                   GtkBorder* border) {
+  GdkAtom actual_type;
+  gint actual_format, actual_length;
+  guchar* data = nullptr;
+  if (!gdk_property_get(window, gdk_atom_intern_static_string(name),
+                        gdk_atom_intern_static_string("CARDINAL"), 0,
+                        4 * 4, FALSE, &actual_type, &actual_format,
+                        &actual_length, &data)) {
+    return FALSE;
+  }
+
+  // 32-bit properties are returned as longs.
+  gboolean found = actual_format == 32 &&
+                   actual_length >= static_cast<gint>(4 * sizeof(long));
+  if (found) {
+    const long* values = reinterpret_cast<const long*>(data);
+    border->left = values[0];
+    border->right = values[1];
+    border->top = values[2];
+    border->bottom = values[3];
+  }
+  g_free(data);
+  return found;
+}
+
+// Gets the sizes of the decorations around |state|'s window: the window
+// manager's frame, and the shadow drawn by client-side decorations. These
+// need a round trip to the display server, so are cached until the
+// decorations or window state change.
+static void get_frame_extents(WindowState* state, GtkBorder* frame_extents,
+                              GtkBorder* shadow_extents) {
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(state->window));
+  if (!state->extents_valid && gdk_window != nullptr) {
+    if (!get_border_property(gdk_window, "_NET_FRAME_EXTENTS",
+                             &state->frame_extents)) {
+      state->frame_extents = {};
+    }
+    if (!get_border_property(gdk_window, "_GTK_FRAME_EXTENTS",
+                             &state->shadow_extents)) {
+      state->shadow_extents = {};
+    }
+    state->extents_valid = TRUE;
+  }
+
+  if (state->extents_valid) {
+    *frame_extents = state->frame_extents;
+    *shadow_extents = state->shadow_extents;
+  } else {
+    *frame_extents = {};
+    *shadow_extents = {};
+  }
+}
+
+// Maps |n_points| packed [x, y] points from window-local coordinates to screen
+// coordinates: offsets them by |origin_x|, |origin_y|, then clamps them to
+// |clamp_rect| if not null, then multiplies them by |scale|.
+static void transform_points(const double* points, size_t n_points,
+                             double origin_x, double origin_y,
+                             const WindowSizeRect* clamp_rect, double scale,
+                             double* result) {
+  double min_x = -G_MAXDOUBLE, min_y = -G_MAXDOUBLE;
+  double max_x = G_MAXDOUBLE, max_y = G_MAXDOUBLE;
+  if (clamp_rect != nullptr) {
+    min_x = clamp_rect->x;
+    min_y = clamp_rect->y;
+    max_x = clamp_rect->x + clamp_rect->width;
+    max_y = clamp_rect->y + clamp_rect->height;
+  }
+
+  for (size_t i = 0; i < n_points; i++) {
+    const double x = CLAMP(points[i * 2] + origin_x, min_x, max_x);
+    const double y = CLAMP(points[i * 2 + 1] + origin_y, min_y, max_y);
+    result[i * 2] = x * scale;
+    result[i * 2 + 1] = y * scale;
+  }
+}
+
+// Arguments for transformPoints.
+typedef struct {
+  const double* points;
+  size_t length;
+  gboolean clamp_to_screen;
+  gboolean to_physical;
+} TransformPointsArgs;
+
+// Reads the arguments for transformPoints, returning FALSE if they are
+// malformed.
+static gboolean get_transform_points_args(FlValue* args,
+                                          TransformPointsArgs* result) {
+  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) return FALSE;
+  FlValue* points_value = fl_value_lookup_string(args, kPointsKey);
+  FlValue* clamp_value = fl_value_lookup_string(args, kClampToScreenKey);
+  FlValue* to_physical_value = fl_value_lookup_string(args, kToPhysicalKey);
+  if (points_value == nullptr ||
+      fl_value_get_type(points_value) != FL_VALUE_TYPE_FLOAT_LIST ||
+      fl_value_get_length(points_value) % 2 != 0 ||
+      (clamp_value != nullptr &&
+       fl_value_get_type(clamp_value) != FL_VALUE_TYPE_BOOL) ||
+      (to_physical_value != nullptr &&
+       fl_value_get_type(to_physical_value) != FL_VALUE_TYPE_BOOL)) {
+    return FALSE;
+  }
+
+  result->points = fl_value_get_float_list(points_value);
+  result->length = fl_value_get_length(points_value);
+  result->clamp_to_screen =
+      clamp_value != nullptr && fl_value_get_bool(clamp_value);
+  result->to_physical =
+      to_physical_value != nullptr && fl_value_get_bool(to_physical_value);
+  return TRUE;
+}
+
+static FlMethodResponse* bad_transform_points_args_response() {
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(
+      kBadArgumentsError,
+      "Expected map with Float64List of packed points, clampToScreen and "
+      "toPhysical",
+      nullptr));
+}
+
+// Maps points in the view of |state|'s window to screen coordinates.
+//
+// Everything used is cached by GDK or the plugin, so this makes no requests
+// to the display server: the window position from the last configure event,
+// the view's offset in the window from its allocation, and the monitor and
+// scale factor from the display snapshot.
+static FlMethodResponse* transform_window_points(FlWindowSizePlugin* self,
+                                                 WindowState* state,
+                                                 FlValue* args) {
+  TransformPointsArgs transform;
+  if (!get_transform_points_args(args, &transform)) {
+    return bad_transform_points_args_response();
+  }
+
+  if (state == nullptr) return no_window_response();
+  GtkWindow* window = state->window;
+
+  // GDK's position of the window's surface, which is inside any window
+  // manager frame. With client-side decorations the surface includes the
+  // shadow, which is part of the view's offset. gtk_window_get_position() is
+  // not used since it queries the window manager frame.
+  gint x = 0, y = 0;
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(window));
+  if (gdk_window != nullptr) gdk_window_get_position(gdk_window, &x, &y);
+  double origin_x = x;
+  double origin_y = y;
+
+  // The view is the window's content in the standard runner, if it isn't the
+  // plugin's own view.
+  GtkWidget* view = GTK_WIDGET(fl_plugin_registrar_get_view(self->registrar));
+  if (view == nullptr || gtk_widget_get_toplevel(view) != GTK_WIDGET(window)) {
+    view = gtk_bin_get_child(GTK_BIN(window));
+  }
+  gint view_x, view_y;
+  if (view != nullptr && gtk_widget_translate_coordinates(
+                             view, GTK_WIDGET(window), 0, 0, &view_x,
+                             &view_y)) {
+    origin_x += view_x;
+    origin_y += view_y;
+  }
+
+  const WindowSizeDisplaySnapshot* snapshot =
+      window_size_display_snapshot_acquire();
+  const WindowSizeRect* clamp_rect = nullptr;
+  double scale = 1.0;
+  for (gint i = 0; i < snapshot->n_windows; i++) {
+    const WindowSizeWindowSnapshot* window_snapshot = &snapshot->windows[i];
+    if (window_snapshot->id != state->id) continue;
+    if (transform.to_physical) scale = window_snapshot->scale_factor;
+    gint monitor = window_snapshot->monitor_index;
+    if (transform.clamp_to_screen && monitor >= 0 &&
+        monitor < snapshot->n_monitors) {
+      clamp_rect = &snapshot->monitors[monitor].visible_frame;
+    }
+    break;
+  }
+
+  g_autofree double* result = g_new(double, MAX(transform.length, 1));
+  transform_points(transform.points, transform.length / 2, origin_x, origin_y,
+                   clamp_rect, scale, result);
+  window_size_display_snapshot_release(snapshot);
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(
+      fl_value_new_float_list(result, transform.length)));
+}
+
+// Converts a border into the Flutter representation.
+static FlValue* make_border_value(const GtkBorder* border) {
+  g_autoptr(FlValue) value = fl_value_new_list();
+
+  fl_value_append_take(value, fl_value_new_float(border->left));
+  fl_value_append_take(value, fl_value_new_float(border->top));
+  fl_value_append_take(value, fl_value_new_float(border->right));
+  fl_value_append_take(value, fl_value_new_float(border->bottom));
+
+  return fl_value_ref(value);
+}
+
+// Enables or disables edge snapping while the window is moved.
+static FlMethodResponse* set_window_snapping(FlWindowSizePlugin* self,
+                                            WindowState* state, FlValue* args) {
+  FlValue* enabled_value = nullptr;
+  FlValue* threshold_value = nullptr;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    enabled_value = fl_value_lookup_string(args, kEnabledKey);
+    threshold_value = fl_value_lookup_string(args, kThresholdKey);
+  }
+  if (enabled_value == nullptr ||
+      fl_value_get_type(enabled_value) != FL_VALUE_TYPE_BOOL ||
+      (threshold_value != nullptr &&
+       fl_value_get_type(threshold_value) != FL_VALUE_TYPE_FLOAT)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected map with enabled and threshold",
+        nullptr));
+  }
+
+  if (state == nullptr) return no_window_response();
+  state->snap_enabled = fl_value_get_bool(enabled_value);
+  state->snap_threshold = threshold_value != nullptr
+                              ? fl_value_get_float(threshold_value)
+                              : kDefaultSnapThreshold;
+  if (!state->snap_enabled) {
+    g_clear_handle_id(&state->snap_timeout_source, g_source_remove);
+  }
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(state->window));
+  if (gdk_window != nullptr) {
+    gdk_window_get_position(gdk_window, &state->snap_last_x,
+                            &state->snap_last_y);
+    state->snap_last_width = gdk_window_get_width(gdk_window);
+    state->snap_last_height = gdk_window_get_height(gdk_window);
+  }
+
+  // Make sure all of the application's windows are known, so that they are
+  // in the display snapshot as snap targets.
+  GtkApplication* app = gtk_window_get_application(state->window);
+  if (state->snap_enabled && app != nullptr) {
+    for (GList* l = gtk_application_get_windows(app); l != nullptr;
+         l = l->next) {
+      get_state_for_window(GTK_WINDOW(l->data));
+    }
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+// Sends |state| to the engine's lifecycle channel.
+static void send_lifecycle_state(FlWindowSizePlugin* self,
+                                 const gchar* state) {
+  g_autoptr(FlValue) message = fl_value_new_string(state);
+  fl_basic_message_channel_send(self->lifecycle_channel, message, nullptr,
+                                nullptr, nullptr);
+}
+
+// Called when the window has been in the background for the memory pressure
+// delay.
+static gboolean memory_pressure_cb(gpointer user_data) {
+  FlWindowSizePlugin* self = FL_WINDOW_SIZE_PLUGIN(user_data);
+  self->memory_pressure_source = 0;
+
+  // Lets the framework and engine drop their caches.
+  g_autoptr(FlValue) message = fl_value_new_map();
+  fl_value_set_string_take(message, kTypeKey,
+                           fl_value_new_string(kMemoryPressureType));
+  fl_basic_message_channel_send(self->system_channel, message, nullptr,
+                                nullptr, nullptr);
+
+  return G_SOURCE_REMOVE;
+}
+
+// Tells the engine the app is paused while the window containing the view is
+// hidden, iconified or withdrawn, and resumed when it is shown again.
+static void update_lifecycle(FlWindowSizePlugin* self) {
+  if (!self->lifecycle_enabled || self->lifecycle_window == nullptr) return;
+
+  GtkWidget* widget = GTK_WIDGET(self->lifecycle_window);
+  GdkWindow* gdk_window = gtk_widget_get_window(widget);
+  gboolean paused = !gtk_widget_get_visible(widget) ||
+                    (gdk_window != nullptr &&
+                     (gdk_window_get_state(gdk_window) &
+                      (GDK_WINDOW_STATE_ICONIFIED |
+                       GDK_WINDOW_STATE_WITHDRAWN)) != 0);
+  if (paused == self->lifecycle_paused) return;
+  self->lifecycle_paused = paused;
+
+  if (paused) {
+    send_lifecycle_state(self, kLifecycleInactive);
+    send_lifecycle_state(self, kLifecyclePaused);
+    if (self->memory_pressure_delay >= 0) {
+      self->memory_pressure_source = g_timeout_add(
+          self->memory_pressure_delay, memory_pressure_cb, self);
+    }
+  } else {
+    g_clear_handle_id(&self->memory_pressure_source, g_source_remove);
+    send_lifecycle_state(self, kLifecycleResumed);
+  }
+}
+
+// Called when the state of the window containing the view changes.
+static gboolean lifecycle_window_state_cb(FlWindowSizePlugin* self,
+                                          GdkEventWindowState* event) {
+  update_lifecycle(self);
+  return FALSE;
+}
+
+// Stops tracking the state of the window containing the view.
+static void stop_lifecycle_tracking(FlWindowSizePlugin* self) {
+  if (self->lifecycle_window == nullptr) return;
+
+  g_signal_handler_disconnect(self->lifecycle_window,
+                              self->lifecycle_state_handler);
+  g_signal_handler_disconnect(self->lifecycle_window,
+                              self->lifecycle_hide_handler);
+  g_signal_handler_disconnect(self->lifecycle_window,
+                              self->lifecycle_show_handler);
+  g_object_remove_weak_pointer(
+      G_OBJECT(self->lifecycle_window),
+      reinterpret_cast<gpointer*>(&self->lifecycle_window));
+  self->lifecycle_window = nullptr;
+}
+
+// Enables or disables lifecycle signals for the window containing the view.
+static FlMethodResponse* set_lifecycle_signals(FlWindowSizePlugin* self,
+                                              FlValue* args) {
+  FlValue* enabled_value = nullptr;
+  FlValue* delay_value = nullptr;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    enabled_value = fl_value_lookup_string(args, kEnabledKey);
+    delay_value = fl_value_lookup_string(args, kMemoryPressureDelayKey);
+  }
+  if (enabled_value == nullptr ||
+      fl_value_get_type(enabled_value) != FL_VALUE_TYPE_BOOL ||
+      (delay_value != nullptr &&
+       fl_value_get_type(delay_value) != FL_VALUE_TYPE_INT)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected map with enabled and memoryPressureDelay",
+        nullptr));
+  }
+
+  WindowState* state = get_window_state(self, kDefaultWindowId);
+  if (state == nullptr) return no_window_response();
+
+  if (self->lifecycle_channel == nullptr) {
+    FlBinaryMessenger* messenger =
+        fl_plugin_registrar_get_messenger(self->registrar);
+    g_autoptr(FlStringCodec) string_codec = fl_string_codec_new();
+    self->lifecycle_channel = fl_basic_message_channel_new(
+        messenger, kLifecycleChannelName, FL_MESSAGE_CODEC(string_codec));
+    g_autoptr(FlJsonMessageCodec) json_codec = fl_json_message_codec_new();
+    self->system_channel = fl_basic_message_channel_new(
+        messenger, kSystemChannelName, FL_MESSAGE_CODEC(json_codec));
+  }
+
+  // The view may have moved to another window since tracking started.
+  if (self->lifecycle_window != state->window) {
+    stop_lifecycle_tracking(self);
+    self->lifecycle_window = state->window;
+    g_object_add_weak_pointer(
+        G_OBJECT(self->lifecycle_window),
+        reinterpret_cast<gpointer*>(&self->lifecycle_window));
+    self->lifecycle_state_handler = g_signal_connect_object(
+        state->window, "window-state-event",
+        G_CALLBACK(lifecycle_window_state_cb), self, G_CONNECT_SWAPPED);
+    self->lifecycle_hide_handler =
+        g_signal_connect_object(state->window, "hide",
+                                G_CALLBACK(update_lifecycle), self,
+                                G_CONNECT_SWAPPED);
+    self->lifecycle_show_handler =
+        g_signal_connect_object(state->window, "show",
+                                G_CALLBACK(update_lifecycle), self,
+                                G_CONNECT_SWAPPED);
+  }
+
+  self->memory_pressure_delay = delay_value != nullptr
+                                    ? fl_value_get_int(delay_value)
+                                    : kDefaultMemoryPressureDelayMs;
+  if (fl_value_get_bool(enabled_value)) {
+    self->lifecycle_enabled = TRUE;
+    update_lifecycle(self);
+  } else {
+    // Hand the lifecycle back to the embedder in the state it expects.
+    if (self->lifecycle_paused) {
+      g_clear_handle_id(&self->memory_pressure_source, g_source_remove);
+      send_lifecycle_state(self, kLifecycleResumed);
+      self->lifecycle_paused = FALSE;
+    }
+    self->lifecycle_enabled = FALSE;
+    stop_lifecycle_tracking(self);
+  }
 
-  return GTK_WINDOW(gtk_widget_get_toplevel(GTK_WIDGET(view)));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
-// Gets the display connection.
-GdkDisplay* get_display(FlWindowSizePlugin* self) {
-  FlView* view = fl_plugin_registrar_get_view(self->registrar);
-  if (view == nullptr) return nullptr;
+// Sets the size and idle timeout of the window pool.
+static FlMethodResponse* configure_window_pool(FlWindowSizePlugin* self,
+                                              FlValue* args) {
+  FlValue* size_value = nullptr;
+  FlValue* idle_timeout_value = nullptr;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    size_value = fl_value_lookup_string(args, kSizeKey);
+    idle_timeout_value = fl_value_lookup_string(args, kIdleTimeoutKey);
+  }
+  if (size_value == nullptr ||
+      fl_value_get_type(size_value) != FL_VALUE_TYPE_INT ||
+      fl_value_get_int(size_value) < 0 ||
+      (idle_timeout_value != nullptr &&
+       (fl_value_get_type(idle_timeout_value) != FL_VALUE_TYPE_INT ||
+        fl_value_get_int(idle_timeout_value) < 0))) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected map with size and idleTimeout",
+        nullptr));
+  }
 
-  return gtk_widget_get_display(GTK_WIDGET(view));
+  window_pool_configure(
+      fl_value_get_int(size_value),
+      idle_timeout_value != nullptr ? fl_value_get_int(idle_timeout_value) : 0);
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
-// Converts frame dimensions into the Flutter representation.
-FlValue* make_frame_value(gint x, gint y, gint width, gint height) {
-  g_autoptr(FlValue) value = fl_value_new_list();
+// Creates a secondary window from the window pool, returning its id.
+static FlMethodResponse* create_window(FlWindowSizePlugin* self,
+                                       FlValue* args) {
+  FlValue* frame_value = nullptr;
+  FlValue* visible_value = nullptr;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    frame_value = fl_value_lookup_string(args, kFrameKey);
+    visible_value = fl_value_lookup_string(args, kVisibleKey);
+  }
+  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP ||
+      (frame_value != nullptr &&
+       (fl_value_get_type(frame_value) != FL_VALUE_TYPE_LIST ||
+        fl_value_get_length(frame_value) != 4)) ||
+      (visible_value != nullptr &&
+       fl_value_get_type(visible_value) != FL_VALUE_TYPE_BOOL)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected map with frame and visible", nullptr));
+  }
 
-  fl_value_append_take(value, fl_value_new_float(x));
-  fl_value_append_take(value, fl_value_new_float(y));
-  fl_value_append_take(value, fl_value_new_float(width));
-  fl_value_append_take(value, fl_value_new_float(height));
+  if (!window_pool_has_factory()) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kNoWindowFactoryError,
+        "Call window_size_plugin_set_window_factory from the runner",
+        nullptr));
+  }
+  GtkWindow* window = window_pool_checkout();
+  if (window == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kNoWindowFactoryError, "The window factory failed", nullptr));
+  }
 
-  return fl_value_ref(value);
+  WindowState* state = get_state_for_window(window);
+  if (frame_value != nullptr) {
+    double x = fl_value_get_float(fl_value_get_list_value(frame_value, 0));
+    double y = fl_value_get_float(fl_value_get_list_value(frame_value, 1));
+    double width = fl_value_get_float(fl_value_get_list_value(frame_value, 2));
+    double height =
+        fl_value_get_float(fl_value_get_list_value(frame_value, 3));
+    gtk_window_move(window, static_cast<gint>(x), static_cast<gint>(y));
+    gtk_window_resize(window, static_cast<gint>(width),
+                      static_cast<gint>(height));
+  }
+  if (visible_value == nullptr || fl_value_get_bool(visible_value)) {
+    gtk_widget_show(GTK_WIDGET(window));
+  }
+
+  // GTK keeps toplevels alive until they are destroyed.
+  g_autoptr(FlValue) result = fl_value_new_int(state->id);
+  g_object_unref(window);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-// Converts monitor information into the Flutter representation.
-FlValue* make_monitor_value(GdkMonitor* monitor) {
-  g_autoptr(FlValue) value = fl_value_new_map();
+// Returns TRUE if the window manager on |screen| lists |hint| in
+// _NET_SUPPORTED. Always FALSE when not running on X11.
+static gboolean window_manager_supports(GdkScreen* screen, const gchar* hint) {
+  GdkAtom actual_type;
+  gint actual_format, actual_length;
+  guchar* data = nullptr;
+  if (!gdk_property_get(gdk_screen_get_root_window(screen),
+                        gdk_atom_intern_static_string("_NET_SUPPORTED"),
+                        gdk_atom_intern_static_string("ATOM"), 0, G_MAXLONG,
+                        FALSE, &actual_type, &actual_format, &actual_length,
+                        &data)) {
+    return FALSE;
+  }
 
-  GdkRectangle frame;
-  gdk_monitor_get_geometry(monitor, &frame);
-  fl_value_set_string_take(
-      value, kFrameKey,
-      make_frame_value(frame.x, frame.y, frame.width, frame.height));
+  // Atom properties are returned as GdkAtoms.
+  GdkAtom hint_atom = gdk_atom_intern_static_string(hint);
+  const GdkAtom* atoms = reinterpret_cast<const GdkAtom*>(data);
+  gint n_atoms = actual_length / static_cast<gint>(sizeof(GdkAtom));
+  gboolean supported = FALSE;
+  for (gint i = 0; i < n_atoms && !supported; i++) {
+    supported = atoms[i] == hint_atom;
+  }
+  g_free(data);
+  return supported;
+}
 
-  gdk_monitor_get_workarea(monitor, &frame);
-  fl_value_set_string_take(
-      value, kVisibleFrameKey,
-      make_frame_value(frame.x, frame.y, frame.width, frame.height));
+// Sets or clears _NET_WM_BYPASS_COMPOSITOR on |state|'s window, which asks a
+// compositing window manager to unredirect the window while it is fullscreen
+// so that its frames go straight to the display. Returns TRUE if the window
+// manager supports the hint.
+static gboolean set_bypass_compositor(WindowState* state, gboolean bypass) {
+  GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(state->window));
+  GdkAtom property = gdk_atom_intern_static_string("_NET_WM_BYPASS_COMPOSITOR");
+  if (!bypass) {
+    if (state->bypass_compositor && gdk_window != nullptr) {
+      gdk_property_delete(gdk_window, property);
+    }
+    state->bypass_compositor = FALSE;
+    return TRUE;
+  }
 
-  gint scale_factor = gdk_monitor_get_scale_factor(monitor);
-  fl_value_set_string_take(value, kScaleFactorKey,
-                           fl_value_new_float(scale_factor));
+  if (gdk_window == nullptr ||
+      !window_manager_supports(gtk_window_get_screen(state->window),
+                               "_NET_WM_BYPASS_COMPOSITOR")) {
+    state->bypass_compositor = FALSE;
+    return FALSE;
+  }
 
-  return fl_value_ref(value);
+  // 1 requests unredirection; 32-bit properties are passed as longs.
+  const long value = 1;
+  gdk_property_change(gdk_window, property,
+                      gdk_atom_intern_static_string("CARDINAL"), 32,
+                      GDK_PROP_MODE_REPLACE,
+                      reinterpret_cast<const guchar*>(&value), 1);
+  state->bypass_compositor = TRUE;
+  return TRUE;
 }
 
-// Gets the list of current screens.
-static FlMethodResponse* get_screen_list(FlWindowSizePlugin* self) {
-  g_autoptr(FlValue) screens = fl_value_new_list();
+// Makes the window fullscreen on a screen, or restores it.
+//
+// The response is deferred until the window manager has applied the change,
+// so that it reports whether the window actually went fullscreen and whether
+// it is bypassing the compositor.
+static FlMethodResponse* set_window_fullscreen(FlWindowSizePlugin* self,
+                                              WindowState* state,
+                                              FlValue* args,
+                                              FlMethodCall* method_call) {
+  FlValue* fullscreen_value = nullptr;
+  FlValue* screen_value = nullptr;
+  FlValue* bypass_value = nullptr;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    fullscreen_value = fl_value_lookup_string(args, kFullscreenKey);
+    screen_value = fl_value_lookup_string(args, kScreenIndexKey);
+    bypass_value = fl_value_lookup_string(args, kBypassCompositorKey);
+  }
+  if (fullscreen_value == nullptr ||
+      fl_value_get_type(fullscreen_value) != FL_VALUE_TYPE_BOOL ||
+      (screen_value != nullptr &&
+       fl_value_get_type(screen_value) != FL_VALUE_TYPE_INT) ||
+      (bypass_value != nullptr &&
+       fl_value_get_type(bypass_value) != FL_VALUE_TYPE_BOOL)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError,
+        "Expected map with fullscreen, screenIndex and bypassCompositor",
+        nullptr));
+  }
 
-  GdkDisplay* display = get_display(self);
-  if (display == nullptr) {
-    return FL_METHOD_RESPONSE(
-        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
+  if (state == nullptr) return no_window_response();
+  GtkWindow* window = state->window;
+  gboolean fullscreen = fl_value_get_bool(fullscreen_value);
+  gint screen_index = -1;
+  if (screen_value != nullptr) {
+    GdkDisplay* display = gtk_widget_get_display(GTK_WIDGET(window));
+    screen_index = fl_value_get_int(screen_value);
+    if (screen_index < 0 ||
+        screen_index >= gdk_display_get_n_monitors(display)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Screen index out of range", nullptr));
+    }
+  }
+  gboolean bypass = fullscreen && bypass_value != nullptr &&
+                    fl_value_get_bool(bypass_value);
+
+  // The hint is read by the window manager when the window goes fullscreen,
+  // so it must be set first; that needs the window to be realized.
+  gtk_widget_realize(GTK_WIDGET(window));
+  set_bypass_compositor(state, bypass);
+
+  // Only the latest request is tracked.
+  g_autoptr(FlMethodResponse) previous_response =
+      make_fullscreen_response(state);
+  finish_fullscreen(state, previous_response);
+
+  if (!fullscreen) {
+    gtk_window_unfullscreen(window);
+  } else if (screen_index >= 0) {
+    gtk_window_fullscreen_on_monitor(window, gtk_window_get_screen(window),
+                                     screen_index);
+  } else {
+    gtk_window_fullscreen(window);
   }
 
-  gint n_monitors = gdk_display_get_n_monitors(display);
-  for (gint i = 0; i < n_monitors; i++) {
-    GdkMonitor* monitor = gdk_display_get_monitor(display, i);
-    fl_value_append_take(screens, make_monitor_value(monitor));
+  // There is nothing to wait for if the window isn't shown, or is already in
+  // the requested state (moving between screens doesn't change the state).
+  if (!gtk_widget_get_mapped(GTK_WIDGET(window)) ||
+      state->fullscreen == fullscreen) {
+    return make_fullscreen_response(state);
   }
 
-  return FL_METHOD_RESPONSE(fl_method_success_response_new(screens));
+  state->fullscreen_call = FL_METHOD_CALL(g_object_ref(method_call));
+  state->fullscreen_requested = fullscreen;
+  state->fullscreen_timeout_source =
+      g_timeout_add(kFullscreenTimeoutMs, fullscreen_timeout_cb, state);
+  return nullptr;
 }
 
 // Gets information about the Flutter window.
-static FlMethodResponse* get_window_info(FlWindowSizePlugin* self) {
-  GtkWindow* window = get_window(self);
-  if (window == nullptr) {
-    return FL_METHOD_RESPONSE(
-        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
-  }
+static FlMethodResponse* get_window_info(FlWindowSizePlugin* self,
+                                         WindowState* state) {
+  if (state == nullptr) return no_window_response();
+  GtkWindow* window = state->window;
 
   g_autoptr(FlValue) window_info = fl_value_new_map();
+  fl_value_set_string_take(window_info, kWindowIdKey,
+                           fl_value_new_int(state->id));
 
   gint x, y, width, height;
   gtk_window_get_position(window, &x, &y);
@@ -137,7 +2236,7 @@ static FlMethodResponse* get_window_info(FlWindowSizePlugin* self) {
 
   // Get the monitor this window is inside, or the primary monitor if doesn't
   // appear to be in any.
-  GdkDisplay* display = get_display(self);
+  GdkDisplay* display = gtk_widget_get_display(GTK_WIDGET(window));
   GdkMonitor* monitor_with_window = gdk_display_get_primary_monitor(display);
   int n_monitors = gdk_display_get_n_monitors(display);
   for (int i = 0; i < n_monitors; i++) {
@@ -157,13 +2256,28 @@ static FlMethodResponse* get_window_info(FlWindowSizePlugin* self) {
   gint scale_factor = gtk_widget_get_scale_factor(GTK_WIDGET(window));
   fl_value_set_string_take(window_info, kScaleFactorKey,
                            fl_value_new_float(scale_factor));
+  fl_value_set_string_take(
+      window_info, kTextScaleFactorKey,
+      fl_value_new_float(
+          get_text_scale_factor(gtk_widget_get_screen(GTK_WIDGET(window)))));
+
+  GtkBorder frame_extents, shadow_extents;
+  get_frame_extents(state, &frame_extents, &shadow_extents);
+  fl_value_set_string_take(window_info, kFrameExtentsKey,
+                           make_border_value(&frame_extents));
+  fl_value_set_string_take(window_info, kShadowExtentsKey,
+                           make_border_value(&shadow_extents));
 
   return FL_METHOD_RESPONSE(fl_method_success_response_new(window_info));
 }
 
 // Sets the window position and dimensions.
+//
+// If the size changes, the response is deferred until the window has been
+// configured and painted at the new size, and nullptr is returned.
 static FlMethodResponse* set_window_frame(FlWindowSizePlugin* self,
-                                          FlValue* args) {
+                                          WindowState* state, FlValue* args,
+                                          FlMethodCall* method_call) {
   if (fl_value_get_type(args) != FL_VALUE_TYPE_LIST ||
       fl_value_get_length(args) != 4) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new(
@@ -174,28 +2288,63 @@ static FlMethodResponse* set_window_frame(FlWindowSizePlugin* self,
   double width = fl_value_get_float(fl_value_get_list_value(args, 2));
   double height = fl_value_get_float(fl_value_get_list_value(args, 3));
 
-  GtkWindow* window = get_window(self);
-  if (window == nullptr) {
-    return FL_METHOD_RESPONSE(
-        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
+  if (state == nullptr) return no_window_response();
+  GtkWindow* window = state->window;
+
+  // A window parked off-screen takes its new position when revealed.
+  if (state->parked && state->parked_off_screen) {
+    state->parked_x = static_cast<gint>(x);
+    state->parked_y = static_cast<gint>(y);
+  } else {
+    gtk_window_move(window, static_cast<gint>(x), static_cast<gint>(y));
   }
 
-  gtk_window_move(window, static_cast<gint>(x), static_cast<gint>(y));
+  gint current_width, current_height;
+  gtk_window_get_size(window, &current_width, &current_height);
+  gboolean resizing = current_width != static_cast<gint>(width) ||
+                      current_height != static_cast<gint>(height);
+  gboolean deferred = resizing && start_resize_sync(state, method_call);
   gtk_window_resize(window, static_cast<gint>(width),
                     static_cast<gint>(height));
 
+  if (deferred) return nullptr;
   return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
+// Gets statistics on how long resizes take to be configured and painted.
+static FlMethodResponse* get_resize_sync_stats(FlWindowSizePlugin* self,
+                                               WindowState* state) {
+  if (state == nullptr) return no_window_response();
+
+  g_autoptr(FlValue) stats = fl_value_new_map();
+  gint64 count = state->resize_sync_count;
+  fl_value_set_string_take(stats, kCountKey, fl_value_new_int(count));
+  fl_value_set_string_take(stats, kTimeoutsKey,
+                           fl_value_new_int(state->resize_sync_timeouts));
+  fl_value_set_string_take(
+      stats, kLastLatencyKey,
+      fl_value_new_float(state->resize_sync_last_latency / 1000.0));
+  fl_value_set_string_take(
+      stats, kAverageLatencyKey,
+      fl_value_new_float(
+          count > 0 ? state->resize_sync_total_latency / 1000.0 / count : 0));
+  fl_value_set_string_take(
+      stats, kMaxLatencyKey,
+      fl_value_new_float(state->resize_sync_max_latency / 1000.0));
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(stats));
+}
+
 // Send updated window geometry to GTK.
-static void update_window_geometry(FlWindowSizePlugin* self) {
+static void update_window_geometry(WindowState* state) {
   gtk_window_set_geometry_hints(
-      get_window(self), nullptr, &self->window_geometry,
+      state->window, nullptr, &state->geometry,
       static_cast<GdkWindowHints>(GDK_HINT_MIN_SIZE | GDK_HINT_MAX_SIZE));
 }
 
 // Sets the window minimum size.
 static FlMethodResponse* set_window_minimum_size(FlWindowSizePlugin* self,
+                                                 WindowState* state,
                                                  FlValue* args) {
   if (fl_value_get_type(args) != FL_VALUE_TYPE_LIST ||
       fl_value_get_length(args) != 2) {
@@ -205,23 +2354,21 @@ static FlMethodResponse* set_window_minimum_size(FlWindowSizePlugin* self,
   double width = fl_value_get_float(fl_value_get_list_value(args, 0));
   double height = fl_value_get_float(fl_value_get_list_value(args, 1));
 
-  if (get_window(self) == nullptr) {
-    return FL_METHOD_RESPONSE(
-        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
-  }
+  if (state == nullptr) return no_window_response();
 
   if (width >= 0 && height >= 0) {
-    self->window_geometry.min_width = static_cast<gint>(width);
-    self->window_geometry.min_height = static_cast<gint>(height);
+    state->geometry.min_width = static_cast<gint>(width);
+    state->geometry.min_height = static_cast<gint>(height);
   }
 
-  update_window_geometry(self);
+  update_window_geometry(state);
 
   return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
 // Sets the window maximum size.
 static FlMethodResponse* set_window_maximum_size(FlWindowSizePlugin* self,
+                                                 WindowState* state,
                                                  FlValue* args) {
   if (fl_value_get_type(args) != FL_VALUE_TYPE_LIST ||
       fl_value_get_length(args) != 2) {
@@ -231,73 +2378,161 @@ static FlMethodResponse* set_window_maximum_size(FlWindowSizePlugin* self,
   double width = fl_value_get_float(fl_value_get_list_value(args, 0));
   double height = fl_value_get_float(fl_value_get_list_value(args, 1));
 
-  if (get_window(self) == nullptr) {
-    return FL_METHOD_RESPONSE(
-        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
-  }
+  if (state == nullptr) return no_window_response();
 
-  self->window_geometry.max_width = static_cast<gint>(width);
-  self->window_geometry.max_height = static_cast<gint>(height);
+  state->geometry.max_width = static_cast<gint>(width);
+  state->geometry.max_height = static_cast<gint>(height);
 
   // Flutter uses -1 as unconstrained, GTK doesn't have an unconstrained value.
-  if (self->window_geometry.max_width < 0) {
-    self->window_geometry.max_width = G_MAXINT;
+  if (state->geometry.max_width < 0) {
+    state->geometry.max_width = G_MAXINT;
   }
-  if (self->window_geometry.max_height < 0) {
-    self->window_geometry.max_height = G_MAXINT;
+  if (state->geometry.max_height < 0) {
+    state->geometry.max_height = G_MAXINT;
   }
 
-  update_window_geometry(self);
+  update_window_geometry(state);
 
   return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
 // Sets the window title.
 static FlMethodResponse* set_window_title(FlWindowSizePlugin* self,
-                                          FlValue* args) {
+                                          WindowState* state, FlValue* args) {
   if (fl_value_get_type(args) != FL_VALUE_TYPE_STRING) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new(
         kBadArgumentsError, "Expected string", nullptr));
   }
 
-  GtkWindow* window = get_window(self);
-  if (window == nullptr) {
-    return FL_METHOD_RESPONSE(
-        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
-  }
+  if (state == nullptr) return no_window_response();
+  GtkWindow* window = state->window;
   gtk_window_set_title(window, fl_value_get_string(args));
 
   return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
+// Parks the window: hides it from the user while keeping it mapped, so that
+// it can be revealed again without going through window placement and
+// the first frame.
+static void park_window(WindowState* state) {
+  if (state->parked) return;
+  GtkWidget* widget = GTK_WIDGET(state->window);
+
+  gtk_window_set_skip_taskbar_hint(state->window, TRUE);
+  gtk_window_set_skip_pager_hint(state->window, TRUE);
+  gtk_window_set_accept_focus(state->window, FALSE);
+
+  // With a compositor the window can simply be made transparent; otherwise
+  // it has to be moved out of sight.
+  state->parked_off_screen = !gdk_screen_is_composited(
+      gtk_window_get_screen(state->window));
+  if (state->parked_off_screen) {
+    gint width, height;
+    gtk_window_get_position(state->window, &state->parked_x,
+                            &state->parked_y);
+    gtk_window_get_size(state->window, &width, &height);
+    gtk_window_move(state->window, -width - kParkedOffset,
+                    -height - kParkedOffset);
+  } else {
+    gtk_widget_set_opacity(widget, 0.0);
+  }
+  gtk_widget_show(widget);
+
+  // Let all input pass through to whatever is below.
+  GdkWindow* gdk_window = gtk_widget_get_window(widget);
+  if (gdk_window != nullptr) {
+    cairo_region_t* empty_region = cairo_region_create();
+    gdk_window_input_shape_combine_region(gdk_window, empty_region, 0, 0);
+    cairo_region_destroy(empty_region);
+  }
+
+  state->parked = TRUE;
+}
+
+// Reverses park_window().
+static void unpark_window(WindowState* state) {
+  if (!state->parked) return;
+  GtkWidget* widget = GTK_WIDGET(state->window);
+
+  GdkWindow* gdk_window = gtk_widget_get_window(widget);
+  if (gdk_window != nullptr) {
+    gdk_window_input_shape_combine_region(gdk_window, nullptr, 0, 0);
+  }
+  if (state->parked_off_screen) {
+    gtk_window_move(state->window, state->parked_x, state->parked_y);
+  } else {
+    gtk_widget_set_opacity(widget, 1.0);
+  }
+  gtk_window_set_skip_taskbar_hint(state->window, FALSE);
+  gtk_window_set_skip_pager_hint(state->window, FALSE);
+  gtk_window_set_accept_focus(state->window, TRUE);
+
+  state->parked = FALSE;
+}
+
 // Sets the window visibility.
 static FlMethodResponse* set_window_visible(FlWindowSizePlugin* self,
-                                          FlValue* args) {
+                                           WindowState* state,
+                                           FlValue* args) {
   if (fl_value_get_type(args) != FL_VALUE_TYPE_BOOL) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new(
         kBadArgumentsError, "Expected bool", nullptr));
   }
 
-  GtkWindow* window = get_window(self);
-  if (window == nullptr) {
-    return FL_METHOD_RESPONSE(
-        fl_method_error_response_new(kNoScreenError, nullptr, nullptr));
-  }
+  if (state == nullptr) return no_window_response();
+  GtkWindow* window = state->window;
   if (fl_value_get_bool(args)) {
-    gtk_widget_show(GTK_WIDGET(window));
+    if (state->parked) {
+      unpark_window(state);
+      gtk_window_present(window);
+    } else {
+      gtk_widget_show(GTK_WIDGET(window));
+    }
   } else {
+    unpark_window(state);
     gtk_widget_hide(GTK_WIDGET(window));
   }
 
   return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
+// Parks or reveals the window.
+static FlMethodResponse* set_window_parked(FlWindowSizePlugin* self,
+                                          WindowState* state, FlValue* args) {
+  if (fl_value_get_type(args) != FL_VALUE_TYPE_BOOL) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected bool", nullptr));
+  }
+
+  if (state == nullptr) return no_window_response();
+  if (fl_value_get_bool(args)) {
+    park_window(state);
+  } else if (state->parked) {
+    unpark_window(state);
+    gtk_window_present(state->window);
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+// Gets whether the window is parked.
+static FlMethodResponse* is_window_parked(FlWindowSizePlugin* self,
+                                         WindowState* state) {
+  if (state == nullptr) return no_window_response();
+
+  g_autoptr(FlValue) result = fl_value_new_bool(state->parked);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
 // Gets the window minimum size.
-static FlMethodResponse* get_window_minimum_size(FlWindowSizePlugin* self) {
+static FlMethodResponse* get_window_minimum_size(FlWindowSizePlugin* self,
+                                                 WindowState* state) {
+  if (state == nullptr) return no_window_response();
+
   g_autoptr(FlValue) size = fl_value_new_list();
 
-  gint min_width = self->window_geometry.min_width;
-  gint min_height = self->window_geometry.min_height;
+  gint min_width = state->geometry.min_width;
+  gint min_height = state->geometry.min_height;
 
   // GTK uses -1 for the requisition size (the size GTK has calculated).
   // Report this as zero (smallest possible) so this doesn't look like Size(-1, -1).
@@ -315,11 +2550,14 @@ static FlMethodResponse* get_window_minimum_size(FlWindowSizePlugin* self) {
 }
 
 // Gets the window maximum size.
-static FlMethodResponse* get_window_maximum_size(FlWindowSizePlugin* self) {
+static FlMethodResponse* get_window_maximum_size(FlWindowSizePlugin* self,
+                                                 WindowState* state) {
+  if (state == nullptr) return no_window_response();
+
   g_autoptr(FlValue) size = fl_value_new_list();
 
-  gint max_width = self->window_geometry.max_width;
-  gint max_height = self->window_geometry.max_height;
+  gint max_width = state->geometry.max_width;
+  gint max_height = state->geometry.max_height;
 
   // Flutter uses -1 as unconstrained, GTK doesn't have an unconstrained value.
   if (max_width == G_MAXINT) {
@@ -335,6 +2573,476 @@ static FlMethodResponse* get_window_maximum_size(FlWindowSizePlugin* self) {
   return FL_METHOD_RESPONSE(fl_method_success_response_new(size));
 }
 
+// Gets the ids of the windows belonging to the application.
+static FlMethodResponse* get_window_list(FlWindowSizePlugin* self,
+                                         WindowState* state) {
+  if (state == nullptr) return no_window_response();
+
+  g_autoptr(FlValue) ids = fl_value_new_list();
+  GtkApplication* app = gtk_window_get_application(state->window);
+  if (app == nullptr) {
+    fl_value_append_take(ids, fl_value_new_int(state->id));
+  } else {
+    for (GList* l = gtk_application_get_windows(app); l != nullptr;
+         l = l->next) {
+      WindowState* window_state = get_state_for_window(GTK_WINDOW(l->data));
+      fl_value_append_take(ids, fl_value_new_int(window_state->id));
+    }
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(ids));
+}
+
+// Computes the frame of the |index|th of |count| windows tiled in |area|.
+static void tile_frame(const GdkRectangle* area, guint index, guint count,
+                       GdkRectangle* frame) {
+  // Use the squarest grid that fits all the windows, letting the windows on
+  // the last row take up any unused columns.
+  guint columns = 1;
+  while (columns * columns < count) columns++;
+  guint rows = (count + columns - 1) / columns;
+  guint row = index / columns;
+  guint column = index % columns;
+  guint columns_in_row = row == rows - 1 ? count - row * columns : columns;
+
+  frame->x = area->x + area->width * column / columns_in_row;
+  frame->width =
+      area->x + area->width * (column + 1) / columns_in_row - frame->x;
+  frame->y = area->y + area->height * row / rows;
+  frame->height = area->y + area->height * (row + 1) / rows - frame->y;
+}
+
+// Computes the frame of the |index|th of |count| windows cascaded in |area|.
+static void cascade_frame(const GdkRectangle* area, guint index, guint count,
+                          GtkWindow* window, GdkRectangle* frame) {
+  gint offset = kCascadeOffset * (count - 1);
+  gint width, height;
+  gtk_window_get_size(window, &width, &height);
+
+  frame->x = area->x + kCascadeOffset * index;
+  frame->y = area->y + kCascadeOffset * index;
+  frame->width = MAX(MIN(width, area->width - offset), 1);
+  frame->height = MAX(MIN(height, area->height - offset), 1);
+}
+
+// Arranges a group of windows on a screen.
+static FlMethodResponse* set_window_group_layout(FlWindowSizePlugin* self,
+                                                 FlValue* args) {
+  FlValue* ids_value = nullptr;
+  FlValue* layout_value = nullptr;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    ids_value = fl_value_lookup_string(args, kWindowIdsKey);
+    layout_value = fl_value_lookup_string(args, kLayoutKey);
+  }
+  if (ids_value == nullptr ||
+      fl_value_get_type(ids_value) != FL_VALUE_TYPE_LIST ||
+      layout_value == nullptr ||
+      fl_value_get_type(layout_value) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected map with window ids and layout",
+        nullptr));
+  }
+  const gchar* layout = fl_value_get_string(layout_value);
+  if (strcmp(layout, kTileLayout) != 0 && strcmp(layout, kCascadeLayout) != 0 &&
+      strcmp(layout, kStackLayout) != 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Unknown layout", nullptr));
+  }
+
+  size_t count = fl_value_get_length(ids_value);
+  g_autoptr(GPtrArray) states = g_ptr_array_new();
+  for (size_t i = 0; i < count; i++) {
+    FlValue* id_value = fl_value_get_list_value(ids_value, i);
+    if (fl_value_get_type(id_value) != FL_VALUE_TYPE_INT) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Expected integer window ids", nullptr));
+    }
+    WindowState* state = get_window_state(self, fl_value_get_int(id_value));
+    if (state == nullptr) return no_window_response();
+    g_ptr_array_add(states, state);
+  }
+  g_autoptr(FlValue) result = fl_value_new_list();
+  if (count == 0) {
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+
+  WindowState* first = static_cast<WindowState*>(g_ptr_array_index(states, 0));
+  GdkDisplay* display = gtk_widget_get_display(GTK_WIDGET(first->window));
+  gint n_monitors = gdk_display_get_n_monitors(display);
+  gint screen_index = -1;
+  FlValue* screen_value = fl_value_lookup_string(args, kScreenIndexKey);
+  if (screen_value != nullptr &&
+      fl_value_get_type(screen_value) == FL_VALUE_TYPE_INT) {
+    screen_index = fl_value_get_int(screen_value);
+    if (screen_index < 0 || screen_index >= n_monitors) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Screen index out of range", nullptr));
+    }
+  }
+
+  // Compute every frame first, so that all the windows are reconfigured
+  // together below.
+  g_autofree GdkRectangle* frames = g_new(GdkRectangle, count);
+  for (size_t i = 0; i < count; i++) {
+    WindowState* state =
+        static_cast<WindowState*>(g_ptr_array_index(states, i));
+
+    // Stacked windows each stay on their own screen unless one is given;
+    // other layouts use the screen of the first window.
+    gint index = screen_index;
+    if (index < 0) {
+      index = get_window_monitor_index(
+          strcmp(layout, kStackLayout) == 0 ? state->window : first->window);
+    }
+    GdkRectangle area;
+    gdk_monitor_get_workarea(gdk_display_get_monitor(display, index), &area);
+
+    if (strcmp(layout, kTileLayout) == 0) {
+      tile_frame(&area, i, count, &frames[i]);
+    } else if (strcmp(layout, kCascadeLayout) == 0) {
+      cascade_frame(&area, i, count, state->window, &frames[i]);
+    } else {
+      frames[i] = area;
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    WindowState* state =
+        static_cast<WindowState*>(g_ptr_array_index(states, i));
+    gtk_window_move(state->window, frames[i].x, frames[i].y);
+    gtk_window_resize(state->window, frames[i].width, frames[i].height);
+
+    // Later windows in the list end up on top.
+    GdkWindow* gdk_window = gtk_widget_get_window(GTK_WIDGET(state->window));
+    if (gdk_window != nullptr) gdk_window_raise(gdk_window);
+
+    fl_value_append_take(result,
+                         make_frame_value(frames[i].x, frames[i].y,
+                                          frames[i].width, frames[i].height));
+  }
+  gdk_display_flush(display);
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Converts a rect into the Flutter frame representation.
+static FlValue* make_rect_value(const WindowSizeRect* rect) {
+  g_autoptr(FlValue) value = fl_value_new_list();
+
+  fl_value_append_take(value, fl_value_new_float(rect->x));
+  fl_value_append_take(value, fl_value_new_float(rect->y));
+  fl_value_append_take(value, fl_value_new_float(rect->width));
+  fl_value_append_take(value, fl_value_new_float(rect->height));
+
+  return fl_value_ref(value);
+}
+
+// Converts a virtual monitor into the Flutter representation.
+static FlValue* make_virtual_monitor_value(const WindowSizeMonitor* monitor) {
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string_take(value, kFrameKey, make_rect_value(&monitor->frame));
+  fl_value_set_string_take(value, kVisibleFrameKey,
+                           make_rect_value(&monitor->visible_frame));
+  fl_value_set_string_take(value, kScaleFactorKey,
+                           fl_value_new_float(monitor->scale_factor));
+  return fl_value_ref(value);
+}
+
+// Converts a [width, height] size argument, returning FALSE if it is
+// malformed.
+static gboolean get_size_args(FlValue* args, double* width, double* height) {
+  if (fl_value_get_type(args) != FL_VALUE_TYPE_LIST ||
+      fl_value_get_length(args) != 2) {
+    return FALSE;
+  }
+  *width = fl_value_get_float(fl_value_get_list_value(args, 0));
+  *height = fl_value_get_float(fl_value_get_list_value(args, 1));
+  return TRUE;
+}
+
+// Arranges the virtual window, which is the only window in headless mode.
+static FlMethodResponse* virtual_set_window_group_layout(
+    FlWindowSizePlugin* self, VirtualDisplay* display, FlValue* args) {
+  FlValue* ids_value = nullptr;
+  FlValue* layout_value = nullptr;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    ids_value = fl_value_lookup_string(args, kWindowIdsKey);
+    layout_value = fl_value_lookup_string(args, kLayoutKey);
+  }
+  if (ids_value == nullptr ||
+      fl_value_get_type(ids_value) != FL_VALUE_TYPE_LIST ||
+      layout_value == nullptr ||
+      fl_value_get_type(layout_value) != FL_VALUE_TYPE_STRING) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Expected map with window ids and layout",
+        nullptr));
+  }
+  const gchar* layout = fl_value_get_string(layout_value);
+  if (strcmp(layout, kTileLayout) != 0 && strcmp(layout, kCascadeLayout) != 0 &&
+      strcmp(layout, kStackLayout) != 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        kBadArgumentsError, "Unknown layout", nullptr));
+  }
+  size_t count = fl_value_get_length(ids_value);
+  for (size_t i = 0; i < count; i++) {
+    FlValue* id_value = fl_value_get_list_value(ids_value, i);
+    if (fl_value_get_type(id_value) != FL_VALUE_TYPE_INT) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Expected integer window ids", nullptr));
+    }
+    gint64 id = fl_value_get_int(id_value);
+    if (id != kDefaultWindowId && id != display->window_id) {
+      return no_window_response();
+    }
+  }
+  gint screen_index = virtual_display_get_window_monitor(display);
+  FlValue* screen_value = fl_value_lookup_string(args, kScreenIndexKey);
+  if (screen_value != nullptr &&
+      fl_value_get_type(screen_value) == FL_VALUE_TYPE_INT) {
+    screen_index = fl_value_get_int(screen_value);
+    if (screen_index < 0 || screen_index >= display->n_monitors) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Screen index out of range", nullptr));
+    }
+  }
+
+  // Every entry is the same window, so each gets the frame it would have as
+  // the only window in the layout.
+  g_autoptr(FlValue) result = fl_value_new_list();
+  if (count == 0) {
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+  const WindowSizeRect* area = &display->monitors[screen_index].visible_frame;
+  WindowSizeRect frame = *area;
+  if (strcmp(layout, kCascadeLayout) == 0) {
+    frame.width = MAX(MIN(display->window_frame.width, area->width), 1);
+    frame.height = MAX(MIN(display->window_frame.height, area->height), 1);
+  }
+  if (virtual_display_set_window_frame(display, &frame)) {
+    display->resize_count++;
+  }
+  publish_virtual_window(display);
+  for (size_t i = 0; i < count; i++) {
+    fl_value_append_take(result, make_rect_value(&display->window_frame));
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Handles a method call against the virtual display, in headless mode.
+//
+// Methods behave as they do with a real display, except that nothing is
+// shown and no events are generated, since the virtual display never changes
+// by itself.
+static FlMethodResponse* virtual_method_call(FlWindowSizePlugin* self,
+                                             VirtualDisplay* display,
+                                             const gchar* method,
+                                             gint64 window_id, FlValue* args) {
+  // Calls that take a list of windows check their ids themselves.
+  if (strcmp(method, kSetWindowGroupLayoutMethod) == 0) {
+    return virtual_set_window_group_layout(self, display, args);
+  }
+  if (strcmp(method, kGetScreenListMethod) == 0) {
+    g_autoptr(FlValue) screens = fl_value_new_list();
+    for (gint i = 0; i < display->n_monitors; i++) {
+      fl_value_append_take(screens,
+                           make_virtual_monitor_value(&display->monitors[i]));
+    }
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(screens));
+  }
+  if (strcmp(method, kClassifyRectsMethod) == 0) {
+    return classify_rects(self, args);
+  }
+  if (strcmp(method, kConvertCoordinatesMethod) == 0) {
+    return convert_coordinates(self, args);
+  }
+  if (strcmp(method, kStartPointerTrackingMethod) == 0 ||
+      strcmp(method, kStopPointerTrackingMethod) == 0) {
+    // There is no pointer, so tracking never reports anything.
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+  }
+
+  if (window_id != kDefaultWindowId && window_id != display->window_id) {
+    return no_window_response();
+  }
+  gint monitor = virtual_display_get_window_monitor(display);
+
+  if (strcmp(method, kGetWindowInfoMethod) == 0) {
+    g_autoptr(FlValue) window_info = fl_value_new_map();
+    fl_value_set_string_take(window_info, kWindowIdKey,
+                             fl_value_new_int(display->window_id));
+    fl_value_set_string_take(window_info, kFrameKey,
+                             make_rect_value(&display->window_frame));
+    fl_value_set_string_take(
+        window_info, kScreenKey,
+        make_virtual_monitor_value(&display->monitors[monitor]));
+    fl_value_set_string_take(
+        window_info, kScaleFactorKey,
+        fl_value_new_float(display->monitors[monitor].scale_factor));
+    GtkBorder no_extents = {};
+    fl_value_set_string_take(window_info, kFrameExtentsKey,
+                             make_border_value(&no_extents));
+    fl_value_set_string_take(window_info, kShadowExtentsKey,
+                             make_border_value(&no_extents));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(window_info));
+  } else if (strcmp(method, kSetWindowFrameMethod) == 0) {
+    if (fl_value_get_type(args) != FL_VALUE_TYPE_LIST ||
+        fl_value_get_length(args) != 4) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Expected 4-element list", nullptr));
+    }
+    WindowSizeRect frame = {
+        fl_value_get_float(fl_value_get_list_value(args, 0)),
+        fl_value_get_float(fl_value_get_list_value(args, 1)),
+        fl_value_get_float(fl_value_get_list_value(args, 2)),
+        fl_value_get_float(fl_value_get_list_value(args, 3))};
+    if (virtual_display_set_window_frame(display, &frame)) {
+      display->resize_count++;
+    }
+    publish_virtual_window(display);
+  } else if (strcmp(method, kSetWindowMinimumSizeMethod) == 0 ||
+             strcmp(method, kSetWindowMaximumSizeMethod) == 0) {
+    double width, height;
+    if (!get_size_args(args, &width, &height)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Expected 2-element list", nullptr));
+    }
+    if (strcmp(method, kSetWindowMinimumSizeMethod) == 0) {
+      if (width >= 0 && height >= 0) {
+        display->min_width = static_cast<gint>(width);
+        display->min_height = static_cast<gint>(height);
+      }
+    } else {
+      display->max_width = width >= 0 ? static_cast<gint>(width) : G_MAXINT;
+      display->max_height =
+          height >= 0 ? static_cast<gint>(height) : G_MAXINT;
+    }
+    // Apply the new limits to the current size.
+    WindowSizeRect frame = display->window_frame;
+    virtual_display_set_window_frame(display, &frame);
+    publish_virtual_window(display);
+  } else if (strcmp(method, kGetWindowMinimumSizeMethod) == 0) {
+    g_autoptr(FlValue) size = fl_value_new_list();
+    fl_value_append_take(size, fl_value_new_float(MAX(display->min_width, 0)));
+    fl_value_append_take(size,
+                         fl_value_new_float(MAX(display->min_height, 0)));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(size));
+  } else if (strcmp(method, kGetWindowMaximumSizeMethod) == 0) {
+    g_autoptr(FlValue) size = fl_value_new_list();
+    fl_value_append_take(
+        size, fl_value_new_float(
+                  display->max_width == G_MAXINT ? -1 : display->max_width));
+    fl_value_append_take(
+        size, fl_value_new_float(
+                  display->max_height == G_MAXINT ? -1 : display->max_height));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(size));
+  } else if (strcmp(method, kSetWindowTitleMethod) == 0) {
+    if (fl_value_get_type(args) != FL_VALUE_TYPE_STRING) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Expected string", nullptr));
+    }
+    g_free(display->window_title);
+    display->window_title = g_strdup(fl_value_get_string(args));
+  } else if (strcmp(method, ksetWindowVisibilityMethod) == 0) {
+    if (fl_value_get_type(args) != FL_VALUE_TYPE_BOOL) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Expected bool", nullptr));
+    }
+    display->window_visible = fl_value_get_bool(args);
+    display->window_parked = FALSE;
+  } else if (strcmp(method, kSetWindowParkedMethod) == 0) {
+    if (fl_value_get_type(args) != FL_VALUE_TYPE_BOOL) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Expected bool", nullptr));
+    }
+    if (fl_value_get_bool(args)) {
+      display->window_parked = TRUE;
+    } else if (display->window_parked) {
+      display->window_parked = FALSE;
+      display->window_visible = TRUE;
+    }
+  } else if (strcmp(method, kIsWindowParkedMethod) == 0) {
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(
+        fl_value_new_bool(display->window_parked)));
+  } else if (strcmp(method, kSetWindowFullscreenMethod) == 0) {
+    FlValue* fullscreen_value = nullptr;
+    FlValue* screen_value = nullptr;
+    if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+      fullscreen_value = fl_value_lookup_string(args, kFullscreenKey);
+      screen_value = fl_value_lookup_string(args, kScreenIndexKey);
+    }
+    if (fullscreen_value == nullptr ||
+        fl_value_get_type(fullscreen_value) != FL_VALUE_TYPE_BOOL ||
+        (screen_value != nullptr &&
+         fl_value_get_type(screen_value) != FL_VALUE_TYPE_INT)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Expected map with fullscreen and screenIndex",
+          nullptr));
+    }
+    gint screen_index =
+        screen_value != nullptr ? fl_value_get_int(screen_value) : monitor;
+    if (screen_index < 0 || screen_index >= display->n_monitors) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new(
+          kBadArgumentsError, "Screen index out of range", nullptr));
+    }
+    if (fl_value_get_bool(fullscreen_value)) {
+      if (!display->window_fullscreen) {
+        display->restore_frame = display->window_frame;
+      }
+      display->window_frame = display->monitors[screen_index].frame;
+      display->window_fullscreen = TRUE;
+    } else if (display->window_fullscreen) {
+      display->window_frame = display->restore_frame;
+      display->window_fullscreen = FALSE;
+    }
+    publish_virtual_window(display);
+
+    // There is no compositor to bypass.
+    g_autoptr(FlValue) result = fl_value_new_map();
+    fl_value_set_string_take(result, kFullscreenKey,
+                             fl_value_new_bool(display->window_fullscreen));
+    fl_value_set_string_take(result, kBypassCompositorKey,
+                             fl_value_new_bool(FALSE));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  } else if (strcmp(method, kTransformPointsMethod) == 0) {
+    TransformPointsArgs transform;
+    if (!get_transform_points_args(args, &transform)) {
+      return bad_transform_points_args_response();
+    }
+    const WindowSizeMonitor* screen = &display->monitors[monitor];
+    g_autofree double* result = g_new(double, MAX(transform.length, 1));
+    transform_points(
+        transform.points, transform.length / 2, display->window_frame.x,
+        display->window_frame.y,
+        transform.clamp_to_screen ? &screen->visible_frame : nullptr,
+        transform.to_physical ? screen->scale_factor : 1.0, result);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(
+        fl_value_new_float_list(result, transform.length)));
+  } else if (strcmp(method, kGetWindowListMethod) == 0) {
+    g_autoptr(FlValue) ids = fl_value_new_list();
+    fl_value_append_take(ids, fl_value_new_int(display->window_id));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(ids));
+  } else if (strcmp(method, kGetResizeSyncStatsMethod) == 0) {
+    // Virtual resizes are presented immediately.
+    g_autoptr(FlValue) stats = fl_value_new_map();
+    fl_value_set_string_take(stats, kCountKey,
+                             fl_value_new_int(display->resize_count));
+    fl_value_set_string_take(stats, kTimeoutsKey, fl_value_new_int(0));
+    fl_value_set_string_take(stats, kLastLatencyKey, fl_value_new_float(0));
+    fl_value_set_string_take(stats, kAverageLatencyKey, fl_value_new_float(0));
+    fl_value_set_string_take(stats, kMaxLatencyKey, fl_value_new_float(0));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(stats));
+  } else if (strcmp(method, kSetWindowIconMethod) != 0 &&
+             strcmp(method, kSetWindowSnappingMethod) != 0 &&
+             strcmp(method, kSetLifecycleSignalsMethod) != 0) {
+    // Icons and snapping have no visible effect without a display, and the
+    // virtual window never goes into the background.
+    return FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
 // Called when a method call is received from Flutter.
 static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
                            gpointer user_data) {
@@ -343,29 +3051,92 @@ static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
   const gchar* method = fl_method_call_get_name(method_call);
   FlValue* args = fl_method_call_get_args(method_call);
 
+  // Calls that target a specific window wrap their arguments in a map with
+  // the window id.
+  gint64 window_id = kDefaultWindowId;
+  if (fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    FlValue* window_id_value = fl_value_lookup_string(args, kWindowIdKey);
+    if (window_id_value != nullptr &&
+        fl_value_get_type(window_id_value) == FL_VALUE_TYPE_INT) {
+      window_id = fl_value_get_int(window_id_value);
+      args = fl_value_lookup_string(args, kArgumentsKey);
+    }
+  }
+  g_autoptr(FlValue) null_args = nullptr;
+  if (args == nullptr) {
+    null_args = fl_value_new_null();
+    args = null_args;
+  }
+
   g_autoptr(FlMethodResponse) response = nullptr;
+  VirtualDisplay* virtual_display = get_virtual_display(self);
+  if (virtual_display != nullptr) {
+    response =
+        virtual_method_call(self, virtual_display, method, window_id, args);
+    g_autoptr(GError) error = nullptr;
+    if (!fl_method_call_respond(method_call, response, &error))
+      g_warning("Failed to send method call response: %s", error->message);
+    return;
+  }
+
+  WindowState* state = get_window_state(self, window_id);
   if (strcmp(method, kGetScreenListMethod) == 0) {
-    response = get_screen_list(self);
+    response = get_screen_list(self, method_call);
   } else if (strcmp(method, kGetWindowInfoMethod) == 0) {
-    response = get_window_info(self);
+    response = get_window_info(self, state);
   } else if (strcmp(method, kSetWindowFrameMethod) == 0) {
-    response = set_window_frame(self, args);
+    response = set_window_frame(self, state, args, method_call);
   } else if (strcmp(method, kSetWindowMinimumSizeMethod) == 0) {
-    response = set_window_minimum_size(self, args);
+    response = set_window_minimum_size(self, state, args);
   } else if (strcmp(method, kSetWindowMaximumSizeMethod) == 0) {
-    response = set_window_maximum_size(self, args);
+    response = set_window_maximum_size(self, state, args);
   } else if (strcmp(method, kSetWindowTitleMethod) == 0) {
-    response = set_window_title(self, args);
+    response = set_window_title(self, state, args);
   } else if (strcmp(method, ksetWindowVisibilityMethod) == 0) {
-    response = set_window_visible(self, args);
+    response = set_window_visible(self, state, args);
   } else if (strcmp(method, kGetWindowMinimumSizeMethod) == 0) {
-    response = get_window_minimum_size(self);
+    response = get_window_minimum_size(self, state);
   } else if (strcmp(method, kGetWindowMaximumSizeMethod) == 0) {
-    response = get_window_maximum_size(self);
+    response = get_window_maximum_size(self, state);
+  } else if (strcmp(method, kGetWindowListMethod) == 0) {
+    response = get_window_list(self, state);
+  } else if (strcmp(method, kSetWindowGroupLayoutMethod) == 0) {
+    response = set_window_group_layout(self, args);
+  } else if (strcmp(method, kSetWindowParkedMethod) == 0) {
+    response = set_window_parked(self, state, args);
+  } else if (strcmp(method, kIsWindowParkedMethod) == 0) {
+    response = is_window_parked(self, state);
+  } else if (strcmp(method, kGetResizeSyncStatsMethod) == 0) {
+    response = get_resize_sync_stats(self, state);
+  } else if (strcmp(method, kStartPointerTrackingMethod) == 0) {
+    response = start_pointer_tracking(self, state);
+  } else if (strcmp(method, kStopPointerTrackingMethod) == 0) {
+    response = stop_pointer_tracking(self);
+  } else if (strcmp(method, kSetWindowIconMethod) == 0) {
+    response = set_window_icon(self, state, args);
+  } else if (strcmp(method, kClassifyRectsMethod) == 0) {
+    response = classify_rects(self, args);
+  } else if (strcmp(method, kConvertCoordinatesMethod) == 0) {
+    response = convert_coordinates(self, args);
+  } else if (strcmp(method, kSetWindowSnappingMethod) == 0) {
+    response = set_window_snapping(self, state, args);
+  } else if (strcmp(method, kSetWindowFullscreenMethod) == 0) {
+    response = set_window_fullscreen(self, state, args, method_call);
+  } else if (strcmp(method, kSetLifecycleSignalsMethod) == 0) {
+    response = set_lifecycle_signals(self, args);
+  } else if (strcmp(method, kConfigureWindowPoolMethod) == 0) {
+    response = configure_window_pool(self, args);
+  } else if (strcmp(method, kCreateWindowMethod) == 0) {
+    response = create_window(self, args);
+  } else if (strcmp(method, kTransformPointsMethod) == 0) {
+    response = transform_window_points(self, state, args);
   } else {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
   }
 
+  // Some methods respond later.
+  if (response == nullptr) return;
+
   g_autoptr(GError) error = nullptr;
   if (!fl_method_call_respond(method_call, response, &error))
     g_warning("Failed to send method call response: %s", error->message);
@@ -375,7 +3146,19 @@ static void fl_window_size_plugin_dispose(GObject* object) {
   FlWindowSizePlugin* self = FL_WINDOW_SIZE_PLUGIN(object);
 
   g_clear_object(&self->registrar);
+  g_clear_pointer(&self->async_calls, async_method_queue_free);
+  g_clear_pointer(&self->virtual_display, virtual_display_free);
+  stop_pointer_updates(self);
+  self->lifecycle_enabled = FALSE;
+  stop_lifecycle_tracking(self);
+  g_clear_handle_id(&self->memory_pressure_source, g_source_remove);
+  g_clear_object(&self->lifecycle_channel);
+  g_clear_object(&self->system_channel);
+  g_clear_handle_id(&self->monitor_refresh_source, g_source_remove);
+  g_clear_pointer(&self->icon_cache, g_hash_table_unref);
+  g_queue_clear(&self->icon_cache_order);
   g_clear_object(&self->channel);
+  monitor_cache_clear(&self->monitor_cache);
 
   G_OBJECT_CLASS(fl_window_size_plugin_parent_class)->dispose(object);
 }
@@ -385,10 +3168,7 @@ static void fl_window_size_plugin_class_init(FlWindowSizePluginClass* klass) {
 }
 
 static void fl_window_size_plugin_init(FlWindowSizePlugin* self) {
-  self->window_geometry.min_width = -1;
-  self->window_geometry.min_height = -1;
-  self->window_geometry.max_width = G_MAXINT;
-  self->window_geometry.max_height = G_MAXINT;
+  self->window_id = kDefaultWindowId;
 }
 
 FlWindowSizePlugin* fl_window_size_plugin_new(FlPluginRegistrar* registrar) {
@@ -396,6 +3176,7 @@ FlWindowSizePlugin* fl_window_size_plugin_new(FlPluginRegistrar* registrar) {
       g_object_new(fl_window_size_plugin_get_type(), nullptr));
 
   self->registrar = FL_PLUGIN_REGISTRAR(g_object_ref(registrar));
+  self->async_calls = async_method_queue_new();
 
   g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
   self->channel =
@@ -404,6 +3185,11 @@ FlWindowSizePlugin* fl_window_size_plugin_new(FlPluginRegistrar* registrar) {
   fl_method_channel_set_method_call_handler(self->channel, method_call_cb,
                                             g_object_ref(self), g_object_unref);
 
+  // Publish the initial geometry for window_size_ffi.h, and record the initial
+  // scale factor.
+  get_monitor_cache(self);
+  check_scale_factor(self);
+
   return self;
 }
 
@@ -411,3 +3197,9 @@ void window_size_plugin_register_with_registrar(FlPluginRegistrar* registrar) {
   FlWindowSizePlugin* plugin = fl_window_size_plugin_new(registrar);
   g_object_unref(plugin);
 }
+
+void window_size_plugin_set_window_factory(WindowSizeWindowFactory factory,
+                                           gpointer user_data,
+                                           GDestroyNotify destroy_notify) {
+  window_pool_set_factory(factory, user_data, destroy_notify);
+}
@@ -0,0 +1,345 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "window_size_snapshot.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "include/window_size/display_snapshot.h"
+
+// How often to check whether replaced snapshots can be freed.
+const guint kReclaimIntervalMs = 100;
+
+// The state that snapshots are built from. Only accessed on the main thread.
+
+// WindowSizeWindowSnapshot by window id.
+static GHashTable* windows = nullptr;
+
+// Id of the window containing the Flutter view, looked up for id 0.
+static gint64 default_window_id = 0;
+
+// Monitors, in getScreenList order.
+static WindowSizeMonitor* monitors = nullptr;
+static gint n_monitors = 0;
+
+// The published state.
+
+// A snapshot with its reference count. Allocated together with the
+// snapshot's monitors and windows, which follow it.
+typedef struct {
+  // Number of readers holding the snapshot, on any thread.
+  gint ref_count;
+
+  // TRUE once the snapshot has been replaced and no reader can still be part
+  // way through acquiring it, see reclaim_snapshots_cb(). Only accessed on
+  // the main thread.
+  gboolean unreachable;
+
+  WindowSizeDisplaySnapshot snapshot;
+} RetainedSnapshot;
+
+// Returned until the first snapshot is published; never freed.
+static RetainedSnapshot empty_snapshot = {};
+
+// The current snapshot. Swapped on the main thread, read from any thread.
+static WindowSizeDisplaySnapshot* current_snapshot = &empty_snapshot.snapshot;
+
+// Number of readers part way through window_size_display_snapshot_acquire(),
+// on any thread. This is only non-zero for the few instructions between a
+// reader loading current_snapshot and taking a reference to it.
+static gint acquiring_readers = 0;
+
+// RetainedSnapshots that have been replaced but may still be held by readers,
+// and the source that frees them. Only accessed on the main thread.
+static GPtrArray* retired_snapshots = nullptr;
+static guint reclaim_source = 0;
+
+// Lock-free copy of the default window's geometry. Only written on the main
+// thread.
+static WindowSizeGeometryMailbox geometry_mailbox = {0, -1};
+
+// Gets the RetainedSnapshot containing |snapshot|.
+static RetainedSnapshot* get_retained_snapshot(
+    const WindowSizeDisplaySnapshot* snapshot) {
+  return reinterpret_cast<RetainedSnapshot*>(
+      const_cast<guint8*>(reinterpret_cast<const guint8*>(snapshot)) -
+      offsetof(RetainedSnapshot, snapshot));
+}
+
+// Builds a snapshot in a single allocation.
+static WindowSizeDisplaySnapshot* build_snapshot(guint64 generation) {
+  gint n_windows = windows != nullptr ? g_hash_table_size(windows) : 0;
+  gsize monitors_size = sizeof(WindowSizeMonitor) * n_monitors;
+  gsize windows_size = sizeof(WindowSizeWindowSnapshot) * n_windows;
+  guint8* data = static_cast<guint8*>(
+      g_malloc(sizeof(RetainedSnapshot) + monitors_size + windows_size));
+
+  RetainedSnapshot* retained = reinterpret_cast<RetainedSnapshot*>(data);
+  retained->ref_count = 0;
+  retained->unreachable = FALSE;
+  WindowSizeDisplaySnapshot* snapshot = &retained->snapshot;
+  WindowSizeMonitor* snapshot_monitors =
+      reinterpret_cast<WindowSizeMonitor*>(data + sizeof(RetainedSnapshot));
+  WindowSizeWindowSnapshot* snapshot_windows =
+      reinterpret_cast<WindowSizeWindowSnapshot*>(
+          data + sizeof(RetainedSnapshot) + monitors_size);
+
+  if (n_monitors > 0) memcpy(snapshot_monitors, monitors, monitors_size);
+  if (n_windows > 0) {
+    GHashTableIter iter;
+    gpointer value;
+    gint i = 0;
+    g_hash_table_iter_init(&iter, windows);
+    while (g_hash_table_iter_next(&iter, nullptr, &value)) {
+      snapshot_windows[i] = *static_cast<WindowSizeWindowSnapshot*>(value);
+      if (snapshot_windows[i].monitor_index >= n_monitors) {
+        snapshot_windows[i].monitor_index = -1;
+      }
+      i++;
+    }
+  }
+
+  snapshot->generation = generation;
+  snapshot->default_window_id = default_window_id;
+  snapshot->monitors = snapshot_monitors;
+  snapshot->n_monitors = n_monitors;
+  snapshot->windows = snapshot_windows;
+  snapshot->n_windows = n_windows;
+  return snapshot;
+}
+
+// Gets the window with |window_id| in |snapshot|, where 0 is the default
+// window.
+static const WindowSizeWindowSnapshot* find_window(
+    const WindowSizeDisplaySnapshot* snapshot, gint64 window_id) {
+  if (window_id == 0) window_id = snapshot->default_window_id;
+  for (gint i = 0; i < snapshot->n_windows; i++) {
+    if (snapshot->windows[i].id == window_id) return &snapshot->windows[i];
+  }
+  return nullptr;
+}
+
+// Copies the default window's geometry from |snapshot| into geometry_mailbox.
+static void update_geometry_mailbox(const WindowSizeDisplaySnapshot* snapshot) {
+  const WindowSizeWindowSnapshot* window = find_window(snapshot, 0);
+
+  // Mark the mailbox as being written; the fence keeps the field stores below
+  // from becoming visible before the odd sequence number.
+  guint32 sequence =
+      __atomic_load_n(&geometry_mailbox.sequence, __ATOMIC_RELAXED);
+  __atomic_store_n(&geometry_mailbox.sequence, sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  if (window == nullptr) {
+    geometry_mailbox.window_id = 0;
+    geometry_mailbox.frame = {};
+    geometry_mailbox.scale_factor = 0;
+    geometry_mailbox.monitor_index = -1;
+    geometry_mailbox.monitor = {};
+  } else {
+    geometry_mailbox.window_id = window->id;
+    geometry_mailbox.frame = window->frame;
+    geometry_mailbox.scale_factor = window->scale_factor;
+    geometry_mailbox.monitor_index = window->monitor_index;
+    geometry_mailbox.monitor = window->monitor_index >= 0
+                                   ? snapshot->monitors[window->monitor_index]
+                                   : WindowSizeMonitor{};
+  }
+
+  __atomic_store_n(&geometry_mailbox.sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+// Frees each retired snapshot once no reader holds it.
+//
+// A reader that loaded a snapshot before it was replaced incremented
+// acquiring_readers first, and takes its reference before decrementing it.
+// So once acquiring_readers is seen to be zero after the replacement, every
+// such reader is counted in the snapshot's ref_count, and no new reader can
+// reach it. Since acquiring_readers is only held for a moment, readers that
+// acquire continually, e.g. every frame, don't stop retired snapshots from
+// being freed.
+static gboolean reclaim_snapshots_cb(gpointer user_data) {
+  if (__atomic_load_n(&acquiring_readers, __ATOMIC_SEQ_CST) == 0) {
+    for (guint i = 0; i < retired_snapshots->len; i++) {
+      static_cast<RetainedSnapshot*>(g_ptr_array_index(retired_snapshots, i))
+          ->unreachable = TRUE;
+    }
+  }
+
+  for (guint i = retired_snapshots->len; i-- > 0;) {
+    RetainedSnapshot* retained =
+        static_cast<RetainedSnapshot*>(g_ptr_array_index(retired_snapshots, i));
+    if (retained->unreachable &&
+        __atomic_load_n(&retained->ref_count, __ATOMIC_SEQ_CST) == 0) {
+      g_ptr_array_remove_index_fast(retired_snapshots, i);
+    }
+  }
+
+  if (retired_snapshots->len > 0) return G_SOURCE_CONTINUE;
+  reclaim_source = 0;
+  return G_SOURCE_REMOVE;
+}
+
+// Builds and publishes a snapshot of the current state.
+static void publish_snapshot() {
+  WindowSizeDisplaySnapshot* old_snapshot = current_snapshot;
+  WindowSizeDisplaySnapshot* snapshot =
+      build_snapshot(old_snapshot->generation + 1);
+  __atomic_store_n(&current_snapshot, snapshot, __ATOMIC_SEQ_CST);
+  update_geometry_mailbox(snapshot);
+
+  if (old_snapshot == &empty_snapshot.snapshot) return;
+  if (retired_snapshots == nullptr) {
+    retired_snapshots = g_ptr_array_new_with_free_func(g_free);
+  }
+  g_ptr_array_add(retired_snapshots, get_retained_snapshot(old_snapshot));
+  if (reclaim_source == 0) {
+    reclaim_source =
+        g_timeout_add(kReclaimIntervalMs, reclaim_snapshots_cb, nullptr);
+  }
+}
+
+void window_size_snapshot_set_window(gint64 window_id,
+                                     const WindowSizeRect* frame,
+                                     double scale_factor,
+                                     gint monitor_index) {
+  if (windows == nullptr) {
+    windows = g_hash_table_new_full(g_int64_hash, g_int64_equal, nullptr,
+                                    g_free);
+  }
+  WindowSizeWindowSnapshot* window = static_cast<WindowSizeWindowSnapshot*>(
+      g_hash_table_lookup(windows, &window_id));
+  if (window == nullptr) {
+    window = g_new0(WindowSizeWindowSnapshot, 1);
+    window->id = window_id;
+    g_hash_table_insert(windows, &window->id, window);
+  }
+  window->frame = *frame;
+  window->scale_factor = scale_factor;
+  window->monitor_index = monitor_index;
+  publish_snapshot();
+}
+
+void window_size_snapshot_set_default_window(gint64 window_id) {
+  default_window_id = window_id;
+  publish_snapshot();
+}
+
+void window_size_snapshot_remove_window(gint64 window_id) {
+  if (windows == nullptr || !g_hash_table_remove(windows, &window_id)) return;
+  publish_snapshot();
+}
+
+void window_size_snapshot_set_monitors(const WindowSizeMonitor* new_monitors,
+                                       gint n_new_monitors) {
+  g_free(monitors);
+  monitors = g_new(WindowSizeMonitor, n_new_monitors);
+  if (n_new_monitors > 0) {
+    memcpy(monitors, new_monitors, sizeof(WindowSizeMonitor) * n_new_monitors);
+  }
+  n_monitors = n_new_monitors;
+  publish_snapshot();
+}
+
+const WindowSizeDisplaySnapshot* window_size_display_snapshot_acquire(void) {
+  __atomic_fetch_add(&acquiring_readers, 1, __ATOMIC_SEQ_CST);
+  WindowSizeDisplaySnapshot* snapshot =
+      __atomic_load_n(&current_snapshot, __ATOMIC_SEQ_CST);
+  __atomic_fetch_add(&get_retained_snapshot(snapshot)->ref_count, 1,
+                     __ATOMIC_SEQ_CST);
+  __atomic_fetch_sub(&acquiring_readers, 1, __ATOMIC_SEQ_CST);
+  return snapshot;
+}
+
+void window_size_display_snapshot_release(
+    const WindowSizeDisplaySnapshot* snapshot) {
+  __atomic_fetch_sub(&get_retained_snapshot(snapshot)->ref_count, 1,
+                     __ATOMIC_SEQ_CST);
+}
+
+WindowSizeRect window_size_get_window_frame(int64_t window_id) {
+  WindowSizeRect frame = {};
+  const WindowSizeDisplaySnapshot* snapshot =
+      window_size_display_snapshot_acquire();
+  const WindowSizeWindowSnapshot* window = find_window(snapshot, window_id);
+  if (window != nullptr) frame = window->frame;
+  window_size_display_snapshot_release(snapshot);
+  return frame;
+}
+
+double window_size_get_window_scale_factor(int64_t window_id) {
+  double scale_factor = 0;
+  const WindowSizeDisplaySnapshot* snapshot =
+      window_size_display_snapshot_acquire();
+  const WindowSizeWindowSnapshot* window = find_window(snapshot, window_id);
+  if (window != nullptr) scale_factor = window->scale_factor;
+  window_size_display_snapshot_release(snapshot);
+  return scale_factor;
+}
+
+int32_t window_size_get_monitor_count(void) {
+  const WindowSizeDisplaySnapshot* snapshot =
+      window_size_display_snapshot_acquire();
+  int32_t count = snapshot->n_monitors;
+  window_size_display_snapshot_release(snapshot);
+  return count;
+}
+
+WindowSizeMonitor window_size_get_monitor(int32_t index) {
+  WindowSizeMonitor monitor = {};
+  const WindowSizeDisplaySnapshot* snapshot =
+      window_size_display_snapshot_acquire();
+  if (index >= 0 && index < snapshot->n_monitors) {
+    monitor = snapshot->monitors[index];
+  }
+  window_size_display_snapshot_release(snapshot);
+  return monitor;
+}
+
+int32_t window_size_get_monitors(WindowSizeMonitor* monitors,
+                                 int32_t capacity) {
+  const WindowSizeDisplaySnapshot* snapshot =
+      window_size_display_snapshot_acquire();
+  int32_t count = snapshot->n_monitors;
+  if (monitors != nullptr && capacity > 0 && count > 0) {
+    memcpy(monitors, snapshot->monitors,
+           sizeof(WindowSizeMonitor) * MIN(count, capacity));
+  }
+  window_size_display_snapshot_release(snapshot);
+  return count;
+}
+
+const WindowSizeGeometryMailbox* window_size_get_geometry_mailbox(void) {
+  return &geometry_mailbox;
+}
+
+void window_size_read_geometry_mailbox(WindowSizeGeometryMailbox* geometry) {
+  while (true) {
+    guint32 sequence =
+        __atomic_load_n(&geometry_mailbox.sequence, __ATOMIC_ACQUIRE);
+    if (sequence % 2 == 0) {
+      *geometry = geometry_mailbox;
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&geometry_mailbox.sequence, __ATOMIC_RELAXED) ==
+          sequence) {
+        geometry->sequence = sequence;
+        return;
+      }
+    }
+
+    // The main thread is part way through an update; let it finish rather
+    // than spinning.
+    g_thread_yield();
+  }
+}
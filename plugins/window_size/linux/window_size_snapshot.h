@@ -0,0 +1,47 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PLUGINS_WINDOW_SIZE_LINUX_WINDOW_SIZE_SNAPSHOT_H_
+#define PLUGINS_WINDOW_SIZE_LINUX_WINDOW_SIZE_SNAPSHOT_H_
+
+// Updates to the geometry read by the functions in window_size_ffi.h and
+// display_snapshot.h. Each update publishes a new snapshot.
+//
+// These must only be called on the GTK main thread.
+
+#include <glib.h>
+
+#include "include/window_size/window_size_ffi.h"
+
+G_BEGIN_DECLS
+
+// Records the frame, scale factor and monitor (as an index into the monitor
+// list, or -1) of the window with |window_id|.
+void window_size_snapshot_set_window(gint64 window_id,
+                                     const WindowSizeRect* frame,
+                                     double scale_factor,
+                                     gint monitor_index);
+
+// Records that id 0 refers to the window with |window_id|.
+void window_size_snapshot_set_default_window(gint64 window_id);
+
+// Forgets the window with |window_id|.
+void window_size_snapshot_remove_window(gint64 window_id);
+
+// Replaces the monitor list with |n_monitors| entries from |monitors|.
+void window_size_snapshot_set_monitors(const WindowSizeMonitor* monitors,
+                                       gint n_monitors);
+
+G_END_DECLS
+
+#endif  // PLUGINS_WINDOW_SIZE_LINUX_WINDOW_SIZE_SNAPSHOT_H_